@@ -0,0 +1,74 @@
+// Benchmark of in-place gate application: interleaved statevector against the
+// split (structure-of-arrays) layout with each available SIMD kernel set.
+// Usage: gate_bench [qubits] (default 20)
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include "component.h"
+#include "statevector.h"
+#include "split_statevector.h"
+#include "simd_kernels.h"
+
+static const int repetitions = 5;
+
+// Starting state with every amplitude non-zero
+static matrix uniform_state(int qubits) {
+    int size = 1 << qubits;
+    matrix state{size, 1};
+    for (int i = 0; i < size; i++) {
+        state.at(i, 0) = std::complex<double>{1.0 / size, 0.5 / size};
+    }
+    return state;
+}
+
+// Applies H to every qubit then CX between neighbours, returns seconds per gate
+template <typename State>
+static double run_layer(State &state, int qubits, const matrix &h, const matrix &x) {
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    for (int r = 0; r < repetitions; r++) {
+        for (int q = 0; q < qubits; q++) {
+            state.apply_single(q, h);
+        }
+        for (int q = 0; q + 1 < qubits; q++) {
+            state.apply_controlled(q, q + 1, x);
+        }
+    }
+    double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    return elapsed / (repetitions * (2 * qubits - 1));
+}
+
+int main(int argc, char* argv[]) {
+    int qubits = argc > 1 ? std::atoi(argv[1]) : 20;
+    matrix input = uniform_state(qubits);
+    const matrix& h = get_gate_matrix(get_gate_info(gate_opcode::h).matrix_id);
+    const matrix& x = get_gate_matrix(get_gate_info(gate_opcode::x).matrix_id);
+
+    statevector reference{input};
+    double base = run_layer(reference, qubits, h, x);
+    matrix expected = reference.to_matrix();
+
+    std::cout << "layout,isa,qubits,ns_per_gate,speedup,max_error" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "interleaved,scalar," << qubits << "," << base * 1e9 << ",1.000,0" << std::endl;
+
+    const simd::isa kernels[] = {simd::isa::scalar, simd::isa::avx2, simd::isa::avx512};
+    for (simd::isa target : kernels) {
+        if (static_cast<int>(target) > static_cast<int>(simd::detect())) {
+            continue;
+        }
+        simd::set_isa(target);
+        split_statevector state{input};
+        double seconds = run_layer(state, qubits, h, x);
+
+        matrix result = state.to_matrix();
+        double max_error = 0;
+        for (int i = 0; i < result.get_rows(); i++) {
+            max_error = std::max(max_error, std::abs(result.at(i, 0) - expected.at(i, 0)));
+        }
+        std::cout << "split," << simd::isa_name(target) << "," << qubits << "," << seconds * 1e9 << ","
+                  << base / seconds << "," << std::scientific << max_error << std::fixed << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Benchmark of dense matrix kernels: compares the original get_value/set_value
+// loops against the tiled operator* and raw-storage tensor_product, and a materialized
+// I (x) ... (x) G (x) ... (x) I times an operand against the lazy kron_operator.
+// Usage: matrix_bench [max_exponent] (default 12, i.e. sizes 2^4 .. 2^12)
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <vector>
+#include "matrix.h"
+#include "kron_operator.h"
+
+// Largest size for which the (very slow) reference GEMM is run
+static const int reference_gemm_limit = 1 << 10;
+
+// Original i-j-k multiply through the range-checked accessors
+static matrix reference_multiply(const matrix &a, const matrix &b) {
+    matrix output(a.get_rows(), b.get_cols());
+    for (int i = 1; i <= a.get_rows(); i++) {
+        for (int j = 1; j <= b.get_cols(); j++) {
+            std::complex<double> sum{0, 0};
+            for (int k = 1; k <= a.get_cols(); k++) {
+                sum = sum + (a.get_value(i, k) * b.get_value(k, j));
+            }
+            output.set_value(i, j, sum);
+        }
+    }
+    return output;
+}
+
+// Original tensor product through the range-checked accessors
+static matrix reference_tensor_product(const matrix &a, const matrix &b) {
+    matrix output{a.get_rows() * b.get_rows(), a.get_cols() * b.get_cols()};
+    for (int i = 1; i <= a.get_rows(); i++) {
+        for (int j = 1; j <= a.get_cols(); j++) {
+            for (int k = 1; k <= b.get_rows(); k++) {
+                for (int l = 1; l <= b.get_cols(); l++) {
+                    int row = (i - 1) * b.get_rows() + k;
+                    int col = (j - 1) * b.get_cols() + l;
+                    output.set_value(row, col, a.get_value(i, j) * b.get_value(k, l));
+                }
+            }
+        }
+    }
+    return output;
+}
+
+static matrix random_matrix(int r, int c, std::mt19937 &rng) {
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    matrix output{r, c};
+    for (int i = 0; i < r; i++) {
+        for (int j = 0; j < c; j++) {
+            output.at(i, j) = std::complex<double>{dist(rng), dist(rng)};
+        }
+    }
+    return output;
+}
+
+// Runs f repeatedly for at least min_seconds and returns seconds per call
+template <typename F>
+static double time_call(F f, double min_seconds) {
+    typedef std::chrono::steady_clock clock;
+    int calls = 0;
+    clock::time_point start = clock::now();
+    double elapsed = 0;
+    do {
+        f();
+        calls++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < min_seconds);
+    return elapsed / calls;
+}
+
+int main(int argc, char* argv[]) {
+    int max_exponent = argc > 1 ? std::atoi(argv[1]) : 12;
+    std::mt19937 rng(42);
+    volatile double sink = 0;
+
+    std::cout << "kernel,size,reference_gflops,tiled_gflops,speedup" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (int e = 4; e <= max_exponent; e++) {
+        int n = 1 << e;
+        matrix a = random_matrix(n, n, rng);
+        matrix b = random_matrix(n, n, rng);
+        double flops = 8.0 * n * n * n;  // Complex multiply-add = 8 real flops
+
+        double tiled = time_call([&]() { sink = sink + (a * b).at(0, 0).real(); }, 0.2);
+        std::cout << "gemm," << n << ",";
+        if (n <= reference_gemm_limit) {
+            double reference = time_call([&]() { sink = sink + reference_multiply(a, b).at(0, 0).real(); }, 0.2);
+            std::cout << flops / reference * 1e-9 << "," << flops / tiled * 1e-9 << "," << reference / tiled << std::endl;
+        } else {
+            std::cout << "," << flops / tiled * 1e-9 << "," << std::endl;
+        }
+
+        // Kronecker product of a single-qubit gate with an (n/2 x n/2) operator
+        matrix gate = random_matrix(2, 2, rng);
+        matrix rest = random_matrix(n / 2, n / 2, rng);
+        double kron_flops = 6.0 * n * n;  // One complex multiply per output entry
+        double kron_reference = time_call([&]() { sink = sink + reference_tensor_product(gate, rest).at(0, 0).real(); }, 0.2);
+        double kron_tiled = time_call([&]() { sink = sink + gate.tensor_product(rest).at(0, 0).real(); }, 0.2);
+        std::cout << "kron," << n << "," << kron_flops / kron_reference * 1e-9 << ","
+                  << kron_flops / kron_tiled * 1e-9 << "," << kron_reference / kron_tiled << std::endl;
+
+        // Gate on the middle of e qubits applied to an (n x n) operand; both columns count the lazy walk's
+        // flops (two complex multiply-adds per amplitude), so the speedup is the time ratio
+        std::vector<matrix> factors(e, matrix{2, 2});
+        factors[e / 2] = gate;
+        const kron_operator lazy{factors};
+        double apply_flops = 14.0 * n * n;
+        double lazy_time = time_call([&]() { sink = sink + lazy.apply(a).at(0, 0).real(); }, 0.2);
+        std::cout << "kron_apply," << n << ",";
+        if (n <= reference_gemm_limit) {
+            const matrix high{1 << (e - 1 - e / 2), 1 << (e - 1 - e / 2)};
+            const matrix low{1 << (e / 2), 1 << (e / 2)};
+            double dense_time = time_call([&]() {
+                sink = sink + (high.tensor_product(gate).tensor_product(low) * a).at(0, 0).real();
+            }, 0.2);
+            std::cout << apply_flops / dense_time * 1e-9 << "," << apply_flops / lazy_time * 1e-9 << ","
+                      << dense_time / lazy_time << std::endl;
+        } else {
+            std::cout << "," << apply_flops / lazy_time * 1e-9 << "," << std::endl;
+        }
+    }
+    return 0;
+}
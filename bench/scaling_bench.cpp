@@ -0,0 +1,65 @@
+// Strong-scaling benchmark: fixed register size, gate sweep time as the thread count grows.
+// Usage: scaling_bench [qubits] [max_threads] (defaults: 22, hardware concurrency)
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include "component.h"
+#include "statevector.h"
+#include "split_statevector.h"
+#include "thread_pool.h"
+
+static const int repetitions = 3;
+
+// Applies H to every qubit then CX between neighbours, returns seconds per gate
+template <typename State>
+static double run_layer(State &state, int qubits, const matrix &h, const matrix &x) {
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    for (int r = 0; r < repetitions; r++) {
+        for (int q = 0; q < qubits; q++) {
+            state.apply_single(q, h);
+        }
+        for (int q = 0; q + 1 < qubits; q++) {
+            state.apply_controlled(q, q + 1, x);
+        }
+    }
+    double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    return elapsed / (repetitions * (2 * qubits - 1));
+}
+
+int main(int argc, char* argv[]) {
+    int qubits = argc > 1 ? std::atoi(argv[1]) : 22;
+    int max_threads = argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+    const matrix& h = get_gate_matrix(get_gate_info(gate_opcode::h).matrix_id);
+    const matrix& x = get_gate_matrix(get_gate_info(gate_opcode::x).matrix_id);
+    matrix input{1 << qubits, 1};  // |0...0>
+
+    std::cout << "layout,qubits,threads,ns_per_gate,speedup,efficiency" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (int split = 0; split <= 1; split++) {
+        double serial = 0;
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            thread_pool::configure_shared(threads);
+            double seconds;
+            if (split) {
+                split_statevector state{input};
+                seconds = run_layer(state, qubits, h, x);
+            } else {
+                statevector state{input};
+                seconds = run_layer(state, qubits, h, x);
+            }
+            if (threads == 1) {
+                serial = seconds;
+            }
+            std::cout << (split ? "split" : "interleaved") << "," << qubits << "," << threads << ","
+                      << seconds * 1e9 << "," << serial / seconds << "," << serial / seconds / threads << std::endl;
+        }
+    }
+    thread_pool::configure_shared(1);
+    return 0;
+}
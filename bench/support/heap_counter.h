@@ -0,0 +1,10 @@
+#ifndef HEAP_COUNTER_H
+#define HEAP_COUNTER_H
+
+#include <cstdint>
+
+// Heap allocations of any kind (matrix blocks, vectors, strings, ...) since the process started. Only
+// the bench executables link heap_counter.cpp, which replaces the global allocation functions to count them.
+std::uint64_t get_heap_allocations();
+
+#endif
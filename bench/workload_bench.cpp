@@ -0,0 +1,176 @@
+// Standard workloads (GHZ, random layered, QFT-like, CX ladder) over a qubit sweep, run through
+// circuit::simulate for both statevector layouts. Peak RSS is the process high-water mark so far,
+// so the sweep runs from small to large registers.
+// Usage: workload_bench [max_qubits] [csv|json] (defaults: 20, csv)
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <sys/resource.h>
+#include "circuit.h"
+#include "support/heap_counter.h"
+
+static const int min_qubits = 4;
+static const int qubit_step = 4;
+static const double min_seconds = 0.2;
+
+// One benchmark result row
+struct workload_result
+{
+    std::string workload;
+    std::string layout;
+    int qubits;
+    std::size_t gates;
+    double seconds;  // Per simulate call
+    double allocations;         // Heap allocations of any kind per simulate call, after a warm-up call
+    double matrix_allocations;  // Of which matrix blocks not served by the arena
+    long peak_rss_kb;
+};
+
+static void add_gate(circuit &c, const std::string &name, std::vector<int> qubits, int register_qubits) {
+    c.add(make_component(name, qubits, register_qubits));
+}
+
+// H on qubit 0 then a CX chain
+static void build_ghz(circuit &c, int qubits) {
+    add_gate(c, "h", {0}, qubits);
+    for (int q = 0; q + 1 < qubits; q++) {
+        add_gate(c, "cx", {q, q + 1}, qubits);
+    }
+}
+
+// As many layers as qubits: a random single-qubit gate on every qubit, then CX on random disjoint pairs
+static void build_random(circuit &c, int qubits) {
+    static const char* singles[] = {"x", "y", "z", "h"};
+    std::mt19937 rng(42);
+    std::vector<int> order(qubits);
+    for (int layer = 0; layer < qubits; layer++) {
+        for (int q = 0; q < qubits; q++) {
+            add_gate(c, singles[rng() % 4], {q}, qubits);
+            order[q] = q;
+        }
+        std::shuffle(order.begin(), order.end(), rng);
+        for (int q = 0; q + 1 < qubits; q += 2) {
+            add_gate(c, "cx", {order[q], order[q + 1]}, qubits);
+        }
+    }
+}
+
+// QFT gate pattern: H on each qubit followed by a controlled phase of pi / 2^(control - target) from every later qubit
+static void build_qft(circuit &c, int qubits) {
+    for (int target = 0; target < qubits; target++) {
+        add_gate(c, "h", {target}, qubits);
+        for (int control = target + 1; control < qubits; control++) {
+            c.add(make_rotation("cphase", {control, target}, qubits, std::ldexp(M_PI, target - control)));
+        }
+    }
+}
+
+// H on every qubit then four passes of a CX ladder, alternating direction
+static void build_cx_ladder(circuit &c, int qubits) {
+    for (int q = 0; q < qubits; q++) {
+        add_gate(c, "h", {q}, qubits);
+    }
+    for (int pass = 0; pass < 4; pass++) {
+        for (int q = 0; q + 1 < qubits; q++) {
+            if (pass % 2 == 0) {
+                add_gate(c, "cx", {q, q + 1}, qubits);
+            } else {
+                add_gate(c, "cx", {qubits - 1 - q, qubits - 2 - q}, qubits);
+            }
+        }
+    }
+}
+
+static long peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;  // Kilobytes on Linux
+}
+
+static workload_result run_workload(const std::string &workload, void (*build)(circuit&, int), int qubits, bool split) {
+    matrix input{1 << qubits, 1};  // |0...0>
+    circuit c{qubits, input, std::vector<char>(qubits, '0')};
+    build(c, qubits);
+    sim_options options;
+    options.split_layout = split;
+
+    volatile double sink = c.simulate(options).at(0, 0).real();  // Warm-up fills the arena
+    reset_matrix_alloc_stats();
+    const std::uint64_t allocations_before = get_heap_allocations();
+    typedef std::chrono::steady_clock clock;
+    int calls = 0;
+    clock::time_point start = clock::now();
+    double elapsed = 0;
+    do {
+        sink = sink + c.simulate(options).at(0, 0).real();
+        calls++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < min_seconds);
+
+    workload_result result;
+    result.workload = workload;
+    result.layout = split ? "split" : "interleaved";
+    result.qubits = qubits;
+    result.gates = c.get_gate_count();
+    result.seconds = elapsed / calls;
+    result.allocations = static_cast<double>(get_heap_allocations() - allocations_before) / calls;
+    result.matrix_allocations = static_cast<double>(get_matrix_alloc_stats().allocations) / calls;
+    result.peak_rss_kb = peak_rss_kb();
+    return result;
+}
+
+static void print_result(const workload_result &r, bool json, bool first) {
+    const double ns_per_gate = r.seconds * 1e9 / r.gates;
+    const double amps_per_second = static_cast<double>(r.gates) * (1 << r.qubits) / r.seconds;
+    if (json) {
+        std::cout << (first ? "" : ",\n") << "  {\"workload\": \"" << r.workload << "\", \"layout\": \"" << r.layout
+                  << "\", \"qubits\": " << r.qubits << ", \"gates\": " << r.gates << ", \"ns_per_gate\": " << ns_per_gate
+                  << ", \"amps_per_sec\": " << amps_per_second << ", \"peak_rss_kb\": " << r.peak_rss_kb
+                  << ", \"allocations_per_run\": " << r.allocations << ", \"matrix_allocations_per_run\": "
+                  << r.matrix_allocations << "}";
+    } else {
+        std::cout << r.workload << "," << r.layout << "," << r.qubits << "," << r.gates << "," << ns_per_gate << ","
+                  << amps_per_second << "," << r.peak_rss_kb << "," << r.allocations << ","
+                  << r.matrix_allocations << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int max_qubits = argc > 1 ? std::atoi(argv[1]) : 20;
+    bool json = argc > 2 && std::string(argv[2]) == "json";
+    if (max_qubits < min_qubits || max_qubits > max_statevector_qubits) {
+        std::cerr << "max_qubits must be between " << min_qubits << " and " << max_statevector_qubits << std::endl;
+        return 1;
+    }
+
+    struct workload { const char* name; void (*build)(circuit&, int); };
+    const workload workloads[] = {{"ghz", build_ghz}, {"random", build_random}, {"qft", build_qft}, {"cx_ladder", build_cx_ladder}};
+    matrix_arena arena;  // Same allocation mode as the main executable
+
+    std::cout << std::setprecision(6);
+    if (json) {
+        std::cout << "[\n";
+    } else {
+        std::cout << "workload,layout,qubits,gates,ns_per_gate,amps_per_sec,peak_rss_kb,allocations_per_run,matrix_allocations_per_run" << std::endl;
+    }
+    bool first = true;
+    for (int qubits = min_qubits; qubits <= max_qubits;
+         qubits = (qubits < max_qubits && qubits + qubit_step > max_qubits) ? max_qubits : qubits + qubit_step) {
+        for (const workload& w : workloads) {
+            for (int split = 0; split <= 1; split++) {
+                print_result(run_workload(w.name, w.build, qubits, split != 0), json, first);
+                first = false;
+            }
+        }
+    }
+    if (json) {
+        std::cout << "\n]" << std::endl;
+    }
+    return 0;
+}
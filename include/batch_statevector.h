@@ -0,0 +1,36 @@
+#ifndef BATCH_STATEVECTOR_H
+#define BATCH_STATEVECTOR_H
+
+#include <complex>
+#include <vector>
+#include <cstddef>
+#include "matrix.h"
+#include "gate_op.h"
+
+// Many statevectors propagated together as a (2^n x B) block, stored row-major so that
+// each gate update works on whole contiguous rows of B amplitudes
+class batch_statevector
+{
+private:
+    std::vector<std::complex<double>> amplitudes;  // Row i holds amplitude i of every batch member
+    int qubits;
+    std::size_t batch;
+
+public:
+    batch_statevector(const std::vector<matrix> &inputs);  // Each input is a (2^n x 1) column vector
+
+    int get_qubits() const;
+    std::size_t get_batch_size() const;
+    std::size_t get_size() const;  // Amplitudes across all batch members
+
+    // Gate application
+    void apply_single(int qubit, const matrix &gate, gate_structure structure = gate_structure::dense);
+    void apply_controlled(int control, int target, const matrix &gate, gate_structure structure = gate_structure::dense);
+    void apply_dense(const gate_qubits &targets, const matrix &block);
+    void apply_diagonal(const std::vector<diagonal_factor> &factors);
+
+    matrix get_state(std::size_t member) const;  // One batch member as a (2^n x 1) column vector
+    std::vector<matrix> to_matrices() const;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "matrix.h"
+
+// Binary statevector checkpoint: this header followed by the 2^qubits amplitudes as interleaved
+// (real, imaginary) pairs of precision-byte floats, in host byte order, amplitude i at bit q = qubit q
+struct checkpoint_header
+{
+    char magic[8];             // "QCSTATE" and a terminating zero
+    std::uint32_t version;
+    std::uint32_t qubits;
+    std::uint32_t precision;   // Bytes per real component: 4 (float) or 8 (double)
+    std::uint32_t reserved;
+    std::uint64_t gate_index;  // Gates of the unfused circuit gate list already applied
+};
+
+const std::uint32_t checkpoint_version = 1;
+
+// Streams the amplitudes straight from the register to path. The file is written under a temporary
+// name and renamed into place, so an interrupted write leaves the previous checkpoint intact.
+template <typename T>
+void write_checkpoint(const std::string &path, const std::complex<T>* amplitudes, int qubits, std::uint64_t gate_index);
+
+// Read-only mapping of a checkpoint file; amplitudes are read from the page cache without a parse buffer
+class checkpoint_file
+{
+private:
+    checkpoint_header header;
+    void* mapped {nullptr};
+    std::size_t mapped_bytes {0};
+
+public:
+    explicit checkpoint_file(const std::string &path);
+    ~checkpoint_file();
+    checkpoint_file(const checkpoint_file&) = delete;
+    checkpoint_file& operator=(const checkpoint_file&) = delete;
+
+    int get_qubits() const;
+    std::size_t get_size() const;
+    bool is_single() const;
+    std::uint64_t get_gate_index() const;
+
+    template <typename T> void copy_to(std::complex<T>* out) const;  // Converts precision if needed
+    matrix to_matrix() const;  // (2^n x 1) column vector, usable as a circuit input
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef CHUNK_KERNELS_H
+#define CHUNK_KERNELS_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "matrix.h"
+#include "gate_op.h"
+
+// Shared machinery of the statevectors that address their amplitudes in chunks of 2^chunk_qubits
+// (windows of the out-of-core file, per-process shards). Stored bits below chunk_qubits index within a
+// chunk and the bits above select the chunk.
+
+// Permutation between logical qubits and stored bits. A gate runs chunk by chunk when every qubit it mixes
+// is stored below chunk_qubits; diagonal gates and controls may sit on any bit.
+class qubit_layout
+{
+private:
+    int chunk_qubits;
+    std::vector<int> position;    // Stored bit of each logical qubit
+    std::vector<int> logical_at;  // Logical qubit held by each stored bit
+
+public:
+    qubit_layout(int qubits, int chunk_qubits);
+
+    int get_chunk_qubits() const;
+    int stored_bit(int qubit) const;
+    bool is_local(const gate_op &op) const;
+    gate_op to_stored(const gate_op &op) const;
+
+    // Moves every high qubit op mixes below chunk_qubits, each time evicting the low qubit whose next use in
+    // gates (from index next) is furthest away. Returns the (high, low) stored bit exchanges to perform.
+    std::vector<std::pair<int, int>> make_local(const gate_op &op, const std::vector<gate_op> &gates, std::size_t next);
+
+    std::size_t stored_index(std::size_t logical_index) const;
+};
+
+// Gate run on stored bits, applied one chunk at a time; consecutive diagonal gates share one sweep
+class chunk_program
+{
+private:
+    struct step
+    {
+        bool diagonal;
+        gate_op op;                             // Unused for diagonal steps
+        std::vector<diagonal_factor> factors;  // Only for diagonal steps
+    };
+    int chunk_qubits;
+    std::vector<step> steps;
+    std::size_t gates {0};
+
+public:
+    chunk_program(const std::vector<gate_op> &stored_run, int chunk_qubits);
+
+    std::size_t get_gate_count() const;
+
+    void apply(std::complex<double>* chunk, std::size_t base) const;  // Chunk starting at stored index base
+};
+
+// Index of the basis state with initial_states[q] ('0' or '1') on qubit q; throws for any other character.
+// Stored and logical order agree before the first gate, so this is also the stored index.
+std::size_t basis_index(const std::vector<char> &initial_states);
+
+// Exchanges stored bit low between two chunks that differ in one high bit: the amplitudes of first with
+// low set trade places with those of second with low clear. [begin, end) ranges over the
+// 2^(chunk_qubits - 1) exchanged pairs, so two workers can split one exchange.
+void swap_between_chunks(std::complex<double>* first, std::complex<double>* second, int low, std::size_t begin, std::size_t end);
+
+// Histogram of sampled bitstrings over the measured qubits (empty = all), highest measured qubit first,
+// drawn in one streaming pass over chunks of chunk_size amplitudes given in stored order
+std::map<std::string, std::uint64_t> sample_chunks(const std::vector<const std::complex<double>*> &chunks, std::size_t chunk_size,
+                                                   const qubit_layout &layout, int qubits, std::uint64_t shots,
+                                                   const std::vector<int> &measured, std::mt19937_64 &rng);
+
+// Dense (2^n x 1) statevector in logical order
+matrix gather_chunks(const std::vector<const std::complex<double>*> &chunks, std::size_t chunk_size, const qubit_layout &layout,
+                     int qubits);
+
+#endif
@@ -6,29 +6,134 @@
 #include <stdexcept>
 #include <bitset>
 #include <iomanip>
+#include <algorithm>
+#include <utility>
 #include "matrix.h"
 #include "component.h"
+#include "statevector.h"
+#include "split_statevector.h"
+#include "batch_statevector.h"
+#include "options.h"
+#include "gate_op.h"
+#include "fusion.h"
+#include "stabilizer.h"
+#include "mps.h"
+#include "mmap_statevector.h"
+#include "sharded_statevector.h"
 
+class compiled_circuit;
+
+// The circuit is kept as a dependency DAG and scheduled as it is built. On each qubit the gates form runs
+// that are diagonal in the same basis (and so commute); a gate depends on every gate of the previous run on
+// each qubit it touches. add() places each gate in the earliest layer after its dependencies where all its
+// qubits are free, so a layer holds qubit-disjoint gates and gates that commute slide past each other.
 class circuit
 {
+    friend class compiled_circuit;
+
 private:
-    std::vector<std::vector<component*>> reg;  // Circuit register (where components are stored)
+    // Scheduling state of one qubit: its current run of commuting gates
+    struct qubit_frontier
+    {
+        gate_axis axis {gate_axis::none};  // Basis of the current run (none: the run cannot grow)
+        int before {-1};                   // Last layer of the previous run
+        int last {-1};                     // Last layer used on the qubit
+        std::vector<int> layers;           // Layers used by the current run, sorted
+    };
+
+    std::vector<component> program;       // Gates as a flat stream, layer by layer
+    std::vector<std::size_t> layer_start;  // Index in program of the first gate of each layer
+    std::vector<qubit_frontier> frontier;
     matrix input_vector;
     std::vector<char> initial_states;  // Stores initial individual qubit states as char (0, 1, +, -)
     int matrix_size;
     int qubits;
+    bool dense;                   // Holds the 2^n input and cached output state
+    statevector cached_state;     // Output of the first cached_layers layers
+    std::size_t cached_layers;
+    gate_list prepared;  // Gate list after fusion, kept for repeated runs until the next add()
+    int prepared_fuse;   // Fusion width prepared was built for (-1: not built)
+
+    template <typename State> static void apply_gates(State &state, const std::vector<gate_op> &gates, bool counting = true);
+    template <typename State> void apply_layers(State &state);  // One apply_layer pass per layer
+    const std::vector<gate_op>& prepare_gates(const sim_options &options);  // Gate list after optional fusion
+    template <typename T> matrix simulate_checkpointed(const sim_options &options);
+    std::size_t layer_end(std::size_t layer) const;
+    void append_layers(std::size_t first, std::size_t last, gate_list &gates) const;
+    std::size_t schedule(const component &comp);  // Layer for a new gate, updating the frontier
+    void require_dense() const;
 
 public:
     ~circuit();
     
     circuit(int qubits, matrix input, std::vector<char> initial_states);
+    // Register without a dense input state, for the tableau, MPS, mmap and sharded backends, which start
+    // from initial_states; the statevector methods and get_current_state are not available
+    circuit(int qubits, std::vector<char> initial_states);
 
     int get_qubits() const;
-    void add(component* comp);
+    bool is_dense() const;
+    void add(const component &comp);  // Schedules the gate into its layer
+    std::size_t get_gate_count() const;
+    std::size_t get_depth() const;  // Number of layers
+    gate_list get_gate_list();  // Gates layer by layer
     matrix get_resultant_matrix();
-    void order_reg();
-    void print_braket(matrix statevector);
+    matrix simulate(const sim_options &options = sim_options());
+    matrix get_current_state();  // Output state of the circuit so far, updated incrementally
+    std::vector<matrix> simulate_batch(const std::vector<matrix> &inputs, const sim_options &options = sim_options());
+    bool is_clifford();  // True when every gate can run on the stabilizer tableau
+    stabilizer_tableau simulate_stabilizer();
+    mps_state simulate_mps(const sim_options &options = sim_options());
+    mmap_statevector simulate_mmap(const sim_options &options = sim_options());
+    sharded_statevector simulate_sharded(const sim_options &options = sim_options());
+    compiled_circuit compile(const sim_options &options = sim_options());  // For runs at many parameter values
+    void print_braket(const matrix &statevector, const braket_format &format = braket_format());
     void draw();
 };
 
+// Circuit compiled once for runs at many parameter values. The gate order and fusion plan are fixed at
+// compile time; binding a parameter point only rebuilds the fused gates that contain a parameterised
+// rotation, from their member gates' 2x2 matrices.
+class compiled_circuit
+{
+private:
+    struct bound_gate  // Fused gate depending on parameters
+    {
+        std::size_t position;       // Index in fused
+        fused_group group;          // Runs indexing members
+        std::vector<gate_op> members;
+        std::vector<std::pair<std::size_t, component>> rotations;  // Parameterised members and their components
+    };
+    int qubits;
+    int parameters;  // Values a parameter point must supply (highest parameter index used + 1)
+    matrix input_vector;
+    gate_list fused;  // Gate list at the components' current angles; also holds the members' rotation matrices
+    std::vector<bound_gate> bound;
+
+    matrix run_point(const std::vector<double> &values, bool counting) const;
+
+public:
+    // program in register order; fuse is the fusion width (0 = none)
+    compiled_circuit(int qubits, const matrix &input, const std::vector<component> &program, int fuse);
+    // Gate ops point into fused, so a compiled circuit can move but not copy
+    compiled_circuit(const compiled_circuit &) = delete;
+    compiled_circuit(compiled_circuit &&) = default;
+
+    int get_parameter_count() const;
+    std::size_t get_gate_count() const;   // Gates applied per run
+    std::size_t get_bound_count() const;  // Gates rebuilt per parameter point
+
+    // values[p] is parameter p; the result's unchanged gates point into this circuit, which must outlive it
+    gate_list bind(const std::vector<double> &values) const;
+    matrix run(const std::vector<double> &values) const;
+    // Output state at every point; points run in parallel on the shared thread pool when there are at
+    // least as many as threads, otherwise one at a time with parallel gate sweeps
+    std::vector<matrix> sweep(const std::vector<std::vector<double>> &points) const;
+};
+
+// Prints a (2^qubits x 1) statevector in bra-ket notation through a buffered writer, filtered as format asks
+void print_braket(const matrix &statevector, int qubits, const braket_format &format = braket_format());
+const char* braket_label(const braket_format &format);  // "ψ = " or "P = " to precede print_braket
+
+
 #endif
\ No newline at end of file
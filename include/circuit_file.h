@@ -0,0 +1,80 @@
+#ifndef CIRCUIT_FILE_H
+#define CIRCUIT_FILE_H
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "options.h"
+
+// Text circuit format, one or more circuits per file:
+//
+//   # comment
+//   qubits 3        starts a circuit
+//   init 010        optional initial state in ket order (qubit n-1 first), default all 0
+//   h 0             single-qubit gate: name qubit
+//   cx 0 1          controlled gate: name control target
+//   param theta 0.5 declares a circuit parameter with its default value (0 if omitted)
+//   rx 0 theta      rotation: name qubit(s) angle, the angle a number in radians or a declared parameter
+//   end             optional, a circuit also ends at the next 'qubits' line or end of input
+//
+// Sweep files (--sweep) hold one parameter point per line as 'name=value' pairs; parameters a point
+// leaves out keep their default.
+
+struct gate_spec
+{
+    std::string name;
+    std::vector<int> qubits;
+    double angle {0};     // Rotations only
+    int parameter {-1};   // Index into circuit_spec::parameter_names, -1 for a literal angle
+    int line;
+};
+
+struct circuit_spec
+{
+    int qubits {0};
+    std::vector<char> initial_states;  // initial_states[q] is the state of qubit q
+    std::vector<gate_spec> gates;
+    std::vector<std::string> parameter_names;
+    std::vector<double> parameter_defaults;
+    int first_line {0};
+};
+
+struct parameter_point
+{
+    std::vector<std::pair<std::string, double>> values;
+    int line;
+};
+
+// Streams circuits one at a time from a circuit file
+class circuit_reader
+{
+private:
+    std::istream &in;
+    std::string line;
+    std::vector<std::string> tokens;
+    int line_number {0};
+    bool header_pending {false};  // tokens already hold the next circuit's 'qubits' line
+
+    bool read_tokens();
+
+public:
+    explicit circuit_reader(std::istream &in);
+
+    // Reads the next circuit; returns false at end of input. Malformed circuits throw
+    // std::runtime_error (with the line number) after being skipped, so reading can continue.
+    bool next(circuit_spec &spec);
+};
+
+// Largest register accepted from a circuit file (only Clifford circuits on the tableau get near it)
+const int max_file_qubits = 1 << 16;
+
+// Reads every point of a sweep file; malformed lines throw std::runtime_error with the line number
+std::vector<parameter_point> read_sweep_points(std::istream &in);
+
+// Simulates every circuit in the stream, printing each result as it finishes (at every point when points
+// is not empty); returns the number of failures
+int run_batch(std::istream &in, const sim_options &options,
+              const std::vector<parameter_point> &points = std::vector<parameter_point>());
+
+#endif
@@ -2,120 +2,73 @@
 #define COMPONENT_H
 
 #include "matrix.h"
+#include "gate_op.h"
+#include "kron_operator.h"
+#include <cstdint>
 #include <string>
 #include <vector>
-#include <cmath>
-#include <complex>
 
-class component
-{
-protected:
-    matrix m{2, 2};
-    std::string symbol;
+// Gates of the component library
+enum class gate_opcode : std::uint8_t { x, y, z, h, cx, cy, cz, ch, rx, ry, rz, phase, crx, cry, crz, cphase };
 
-public:
-    virtual ~component() {}
-    component(matrix mat, std::string sym);
-    virtual matrix get_matrix();
-    virtual std::string get_symbol();
-};
+// Pauli axis whose eigenbasis a 2x2 gate is diagonal in. Gates that are diagonal in the same basis on
+// every qubit they share commute; controls count as z.
+enum class gate_axis : std::uint8_t { none, x, y, z };
 
-class single_component : public component
+// Entry of the shared gate table, one per opcode
+struct gate_info
 {
-protected:
-    int qubit;
-
-public:
-    virtual ~single_component() {}
-    single_component(matrix mat, std::string sym, int q);
-    virtual int get_qubit();
+    const char* name;         // Library name ("x", "cx", ...)
+    const char* symbol;       // Symbol drawn in the circuit diagram
+    bool controlled;
+    bool clifford;            // Runs on the stabilizer tableau
+    bool parameterized;       // Rotation whose matrix is built from the component's angle
+    std::uint16_t matrix_id;  // Shared 2x2 matrix applied to the (target) qubit (fixed gates only)
+    gate_structure structure;
+    gate_axis axis;           // Basis the (target) matrix is diagonal in
 };
 
-class pauli_x : public single_component
+// One gate of a circuit: plain data, copied by value. Matrices are not stored per gate but shared
+// through the gate table, so a circuit is a flat, cache-friendly instruction stream. Rotations carry
+// their angle and build their 2x2 matrix when converted.
+struct component
 {
-public:
-    ~pauli_x() {}
-    pauli_x(int q);
+    gate_opcode op;
+    std::uint16_t matrix_id;
+    std::int32_t qubits[2];  // {qubit, -1} for single-qubit gates, {control, target} for controlled gates
+    std::int32_t parameter;  // Rotations: index of the circuit parameter bound to angle, -1 for a literal angle
+    double angle;            // Rotations: angle in radians (the parameter's current value when bound)
 };
 
-class pauli_y : public single_component
-{
-public:
-    ~pauli_y() {}
-    pauli_y(int q);
-};
-
-class pauli_z : public single_component
-{
-public:
-    ~pauli_z() {}
-    pauli_z(int q);
-};
-
-class hadamard : public single_component
-{
-public:
-    ~hadamard() {}
-    hadamard(int q);
-};
-
-class identity : public single_component
-{
-public:
-    ~identity() {}
-    identity(int size);
-};
+// Ids of the auxiliary matrices in the shared table
+const std::uint16_t identity_matrix_id = 4;
+const std::uint16_t projector0_matrix_id = 5;  // |0><0|
+const std::uint16_t projector1_matrix_id = 6;  // |1><1|
 
-class projector : public single_component
-{
-public:
-    ~projector() {}
-    projector(bool is_p0);
-};
+const gate_info& get_gate_info(gate_opcode op);
+const gate_info* find_gate_info(const std::string &name);  // nullptr for names not in the library
+const matrix& get_gate_matrix(std::uint16_t matrix_id);  // Shared constant 2x2 matrix
 
-class multi_component : public component
-{
-protected:
-    int control;
-    int target;
-    int qubits;
+// 2x2 matrix of a rotation opcode (of its target for the controlled ones) at the given angle:
+// rx/ry/rz are exp(-i angle/2 P) for the Pauli P, phase is diag(1, exp(i angle))
+matrix rotation_matrix(gate_opcode op, double angle);
 
-public:
-    virtual ~multi_component() {}
-    multi_component(matrix mat, std::string sym, int c, int t, int qs);
-    virtual int get_target();
-    virtual int get_control();
-    matrix construct_controlled_matrix(const matrix &gate_matrix);
-    matrix compute_tensor_product(const std::vector<matrix> &product_vector);
-};
+// 2x2 matrix the component applies to its (target) qubit
+matrix component_matrix(const component &comp);
 
-// Controlled gate classes
-class controlled_x : public multi_component
-{
-public:
-    ~controlled_x() {}
-    controlled_x(int c, int t, int qs);
-};
+// Creates a library component by name ("x", "y", "z", "h", "cx", "cy", "cz", "ch");
+// qubits holds {qubit} for single-qubit gates and {control, target} for controlled gates
+component make_component(const std::string &name, const std::vector<int> &qubits, int register_qubits);
 
-class controlled_y : public multi_component
-{
-public:
-    ~controlled_y() {}
-    controlled_y(int c, int t, int qs);
-};
+// Creates a rotation ("rx", "ry", "rz", "phase", "crx", "cry", "crz", "cphase") at angle, optionally
+// bound to circuit parameter index parameter (angle is then its default value)
+component make_rotation(const std::string &name, const std::vector<int> &qubits, int register_qubits, double angle,
+                        int parameter = -1);
 
-class controlled_z : public multi_component
-{
-public:
-    ~controlled_z() {}
-    controlled_z(int c, int t, int qs);
-};
+// Gate as seen by the simulation engines; a rotation's matrix is kept in list
+gate_op to_gate_op(const component &comp, gate_list &list);
 
-class controlled_h : public multi_component
-{
-public:
-    ~controlled_h() {}
-    controlled_h(int c, int t, int qs);
-};
+// Controlled component on the whole register as the lazy sum |0><0|_c (x) I + |1><1|_c (x) U_t
+kron_operator controlled_operator(const component &comp, int register_qubits);
 
-#endif
\ No newline at end of file
+#endif
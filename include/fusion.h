@@ -0,0 +1,26 @@
+#ifndef FUSION_H
+#define FUSION_H
+
+#include <cstddef>
+#include <vector>
+#include "gate_op.h"
+
+// Embeds a gate's local matrix into the larger qubit set (which must contain all of op.qubits)
+matrix expand_matrix(const gate_op &op, const std::vector<int> &qubits);
+
+// Gates of a list that fuse into one, in order: each run is a run of single-qubit gates on one qubit
+// (merged into one 2x2 gate) or a lone multi-qubit gate, given as indices into the gate list
+struct fused_group
+{
+    std::vector<std::vector<std::size_t>> runs;
+};
+
+// Fusion decisions only depend on which qubits each gate touches, so a plan can be rebuilt with
+// different gate matrices on the same qubits (see compiled_circuit)
+std::vector<fused_group> plan_fusion(const std::vector<gate_op> &gates, int max_qubits);
+gate_op build_fused_gate(const fused_group &group, const std::vector<gate_op> &gates, gate_list &out);  // Keeps new matrices in out
+
+// Merges single-qubit runs, then greedily fuses neighbouring gates into dense blocks on at most max_qubits qubits
+gate_list fuse_gates(gate_list gates, int max_qubits);
+
+#endif
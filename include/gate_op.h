@@ -0,0 +1,106 @@
+#ifndef GATE_OP_H
+#define GATE_OP_H
+
+#include <vector>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include "matrix.h"
+
+// Sparsity structure of a gate matrix, used by the engines to pick cheaper kernels
+enum class gate_structure { dense, diagonal, permutation, phase_permutation };
+
+gate_structure classify_structure(const matrix &m);
+
+// Unit phases that can be applied without a complex multiply
+enum phase_kind { phase_one, phase_minus_one, phase_i, phase_minus_i, phase_general };
+
+inline phase_kind classify_phase(std::complex<double> f) {
+    if (f == std::complex<double>{1, 0}) return phase_one;
+    if (f == std::complex<double>{-1, 0}) return phase_minus_one;
+    if (f == std::complex<double>{0, 1}) return phase_i;
+    if (f == std::complex<double>{0, -1}) return phase_minus_i;
+    return phase_general;
+}
+
+// Multiplies a by f, using sign flips and real/imaginary swaps for unit phases
+template <typename T>
+inline std::complex<T> apply_phase(phase_kind kind, std::complex<T> f, std::complex<T> a) {
+    switch (kind) {
+        case phase_one: return a;
+        case phase_minus_one: return -a;
+        case phase_i: return std::complex<T>{-a.imag(), a.real()};
+        case phase_minus_i: return std::complex<T>{a.imag(), -a.real()};
+        default: return f * a;
+    }
+}
+
+// Largest number of qubits a dense block may act on
+const int max_dense_qubits = 6;
+
+// Qubits of a gate, stored inline: single: {qubit}; controlled: {control, target}; dense: entry j is bit j
+// of the block index
+struct gate_qubits
+{
+    std::int32_t count;
+    std::int32_t index[max_dense_qubits];
+
+    std::size_t size() const { return static_cast<std::size_t>(count); }
+    std::int32_t operator[](std::size_t j) const { return index[j]; }
+    std::int32_t& operator[](std::size_t j) { return index[j]; }
+    const std::int32_t* begin() const { return index; }
+    const std::int32_t* end() const { return index + count; }
+    std::int32_t* begin() { return index; }
+    std::int32_t* end() { return index + count; }
+};
+
+// Flattened gate as seen by the simulation engines: plain data, copied by value. The matrix is not stored
+// per gate; fixed gates point at the shared gate table and computed matrices (rotations, merged runs,
+// fused blocks) at the gate_list that produced them.
+struct gate_op
+{
+    enum op_kind { single, controlled, dense };
+
+    op_kind kind;
+    gate_qubits qubits;
+    const matrix* m;  // 2x2 gate for single/controlled, 2^k x 2^k block for dense
+    gate_structure structure;
+
+    gate_op(op_kind kind, std::initializer_list<int> qubits, const matrix *m, gate_structure structure);
+    gate_op(op_kind kind, const std::vector<int> &qubits, const matrix *m);  // Structure classified from *m
+};
+
+// Gate ops together with the computed matrices they point to. The matrices sit in a deque so they never
+// move while the list grows or is moved; a copy points its ops at its own copies of them.
+struct gate_list
+{
+    std::vector<gate_op> gates;
+    std::deque<matrix> matrices;
+
+    gate_list() = default;
+    gate_list(const gate_list &other);
+    gate_list(gate_list &&other) = default;
+    gate_list& operator=(gate_list other);
+
+    const matrix* keep(matrix m);  // Stores m for the list's ops and returns its address
+    void clear();
+};
+
+// Phase applied to every amplitude whose index bits under mask equal value
+struct diagonal_factor
+{
+    std::size_t mask;
+    std::size_t value;
+    std::complex<double> phase;
+    phase_kind kind;
+};
+
+// Appends the non-trivial phases of a diagonal gate
+void append_diagonal_factors(const gate_op &op, std::vector<diagonal_factor> &factors);
+
+// True when every factor is -1 (batches of Z and CZ)
+bool all_sign_flips(const std::vector<diagonal_factor> &factors);
+
+#endif
@@ -11,14 +11,26 @@
 void error_msg(std::string message);
 
 matrix get_input_vector(std::vector<char> initial_states);
-int get_qubits_from_user();
+matrix load_input_vector(const std::string &path, int qubits);
+int get_qubits_from_user(int max_qubits);
 std::vector<char> get_initial_states_from_user(int qubits);
 std::string get_component_from_user(const std::vector<std::string>& comp_library);
 
 void print_library(const std::vector<std::string>& comp_library);
-void add_components(circuit& c, std::vector<component*>& comp_added, const std::vector<std::string>& comp_library, int qubits);
-void add_single_qubit_component(circuit& c, std::vector<component*>& comp_added, const std::string& comp_name, int qubits);
-void add_multi_qubit_component(circuit& c, std::vector<component*>& comp_added, const std::string& comp_name, int qubits);
-void calculate_and_display_results(circuit& c, const matrix& input_vector);
+void add_components(circuit& c, const std::vector<std::string>& comp_library, int qubits);
+void add_single_qubit_component(circuit& c, const std::string& comp_name, int qubits);
+void add_multi_qubit_component(circuit& c, const std::string& comp_name, int qubits);
+void calculate_and_display_results(circuit& c, const matrix& input_vector, const sim_options& options);
+void calculate_and_display_batch_results(circuit& c, int qubits, const sim_options& options);
+void display_measurements(const matrix& state, const sim_options& options);
+void display_measurements(const stabilizer_tableau& tableau, const sim_options& options);
+void display_measurements(const mps_state& state, const sim_options& options);
+void display_measurements(const mmap_statevector& state, const sim_options& options);
+void display_measurements(const sharded_statevector& state, const sim_options& options);
+void display_stabilizers(const stabilizer_tableau& tableau);
+// Output of the backends that keep their own state, shared by the interactive and batch results
+void display_backend_output(const mps_state& state, const sim_options& options);
+void display_backend_output(const mmap_statevector& state, const sim_options& options);
+void display_backend_output(const sharded_statevector& state, const sim_options& options);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef KRON_OPERATOR_H
+#define KRON_OPERATOR_H
+
+#include <cstddef>
+#include <vector>
+#include "matrix.h"
+
+// Operator on n qubits kept as a sum of Kronecker products of 2x2 factors, one factor per qubit, so
+// I (x) ... (x) G (x) ... (x) I costs O(n) memory instead of O(4^n). Applying it walks the non-identity
+// factors over the rows of the operand in place; the dense 2^n x 2^n form is only built by to_matrix.
+// In the dense form the factor of qubit n-1 is leftmost, as in matrix::tensor_product chains.
+class kron_operator
+{
+private:
+    int qubits;
+    std::vector<std::vector<matrix>> terms;  // terms[t][q] is the factor of term t acting on qubit q
+    std::vector<std::vector<int>> active;    // Qubits of each term whose factor is not the identity
+
+    void apply_term(std::size_t term, matrix &m) const;
+
+public:
+    explicit kron_operator(int qubits);  // The zero operator; add_term builds up the sum
+    kron_operator(const std::vector<matrix> &factors);  // Single product, factors[q] acting on qubit q
+
+    void add_term(const std::vector<matrix> &factors);
+
+    int get_qubits() const;
+    std::size_t get_term_count() const;
+
+    void apply_in_place(matrix &m) const;  // m = op * m for any (2^n x k) m, without forming op
+    matrix apply(const matrix &m) const;
+    matrix to_matrix() const;  // Dense (2^n x 2^n) operator, only when explicitly needed
+};
+
+#endif
@@ -4,16 +4,46 @@
 #include <iostream>
 #include <limits>
 #include <complex>
+#include <cstdint>
+
+// Counts of matrix storage requests since the last reset
+struct matrix_alloc_stats
+{
+    std::uint64_t allocations;  // Blocks taken from the heap
+    std::uint64_t reuses;       // Blocks recycled from an arena free list
+    std::uint64_t bytes;        // Bytes taken from the heap
+};
+
+matrix_alloc_stats get_matrix_alloc_stats();
+void reset_matrix_alloc_stats();
+
+// While an arena is alive on a thread, freed matrix blocks on that thread are kept in per-size free lists
+// and handed to the next matrix of the same size instead of going back to the heap. The lists are released
+// when the outermost arena closes. Blocks may outlive the arena; they are then freed normally.
+class matrix_arena
+{
+public:
+    matrix_arena();
+    ~matrix_arena();
+    matrix_arena(const matrix_arena&) = delete;
+    matrix_arena& operator=(const matrix_arena&) = delete;
+};
 
 class matrix
 {
     friend std::ostream& operator<<(std::ostream &os, const matrix &m);
     friend std::istream& operator>>(std::istream &is, matrix &m);
+    friend void multiply_into(const matrix &a, const matrix &b, matrix &out);
+    friend void kron_into(const matrix &a, const matrix &b, matrix &out);
+    friend void add_into(const matrix &a, const matrix &b, matrix &out);
 
 private:
     std::complex<double>* matrix_data {nullptr};
-    int rows;
-    int columns;
+    int rows {0};
+    int columns {0};
+    static const int block_size = 64;  // Tile edge used by operator*
+
+    void reshape(int r, int c);  // Resize without initialising, keeping the block when the size is unchanged
 
 public:
     // Constructors, Destructor, and Operators
@@ -33,6 +63,12 @@ public:
     
     void set_dimensions(const int &r, const int &c);
 
+    // Unchecked accessors (0-indexed, no range check) for hot loops
+    std::complex<double>* data();
+    const std::complex<double>* data() const;
+    std::complex<double>& at(int m, int n);
+    const std::complex<double>& at(int m, int n) const;
+
     // Matrix Manipulation Methods
     int index(const int &m, const int &n) const;
     void set_value(const int &m, const int &n, std::complex<double> value);
@@ -46,4 +82,16 @@ public:
     matrix tensor_product(const matrix &m) const;
 };
 
+// In-place variants: out is resized to fit, reusing its storage when the element count already matches.
+// out may alias an operand of add_into but not of multiply_into or kron_into.
+void multiply_into(const matrix &a, const matrix &b, matrix &out);  // out = a * b
+void kron_into(const matrix &a, const matrix &b, matrix &out);      // out = a.tensor_product(b)
+void add_into(const matrix &a, const matrix &b, matrix &out);       // out = a + b
+
+// Inline definitions of unchecked accessors
+inline std::complex<double>* matrix::data() { return matrix_data; }
+inline const std::complex<double>* matrix::data() const { return matrix_data; }
+inline std::complex<double>& matrix::at(int m, int n) { return matrix_data[n + m * columns]; }
+inline const std::complex<double>& matrix::at(int m, int n) const { return matrix_data[n + m * columns]; }
+
 #endif
\ No newline at end of file
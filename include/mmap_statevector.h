@@ -0,0 +1,63 @@
+#ifndef MMAP_STATEVECTOR_H
+#define MMAP_STATEVECTOR_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "matrix.h"
+#include "gate_op.h"
+#include "chunk_kernels.h"
+
+// Out-of-core statevector: the 2^n amplitudes live in an unlinked memory-mapped file, so registers larger
+// than RAM are limited by disk space instead. Gates are applied in streaming passes over chunks of
+// 2^chunk_qubits amplitudes; consecutive gates whose targets are below the chunk size share one pass.
+// A gate targeting a higher qubit first swaps that qubit with a low one in a blockwise pass, so the stored
+// bit order is a permutation of the logical qubits (tracked here and undone when reading results).
+class mmap_statevector
+{
+private:
+    int qubits;
+    int chunk_qubits;
+    std::size_t size;
+    std::complex<double>* amplitudes {nullptr};
+    int fd {-1};
+    qubit_layout layout;
+    std::uint64_t gate_passes {0};
+    std::uint64_t swap_passes {0};
+
+    void swap_bits(int high, int low);  // Blockwise pass exchanging a stored bit above the chunk with one inside it
+    void run_pass(const std::vector<gate_op> &run);
+
+public:
+    // Register in the basis state given by initial_states ('0'/'1' per qubit), stored in a file under dir
+    mmap_statevector(const std::vector<char> &initial_states, int chunk_qubits, const std::string &dir);
+    ~mmap_statevector();
+    mmap_statevector(mmap_statevector &&other) noexcept;
+    mmap_statevector(const mmap_statevector&) = delete;
+    mmap_statevector& operator=(const mmap_statevector&) = delete;
+    mmap_statevector& operator=(mmap_statevector&&) = delete;
+
+    int get_qubits() const;
+    int get_chunk_qubits() const;
+    std::size_t get_size() const;
+    std::uint64_t get_gate_passes() const;  // Streaming passes that applied gates
+    std::uint64_t get_swap_passes() const;  // Passes that moved a high qubit into the chunk
+
+    void apply_gates(const std::vector<gate_op> &gates);
+
+    matrix to_matrix() const;  // Dense (2^n x 1) statevector in logical order, only for registers matrix can index
+
+    // Histogram of sampled bitstrings over the measured qubits (empty = all), highest measured qubit first.
+    // One streaming pass over the file whatever the number of qubits.
+    std::map<std::string, std::uint64_t> sample_counts(std::uint64_t shots, const std::vector<int> &measured,
+                                                       std::mt19937_64 &rng) const;
+};
+
+// Largest register the out-of-core backend accepts (2^40 amplitudes is a 16 TiB file)
+const int max_mmap_qubits = 40;
+
+#endif
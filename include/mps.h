@@ -0,0 +1,57 @@
+#ifndef MPS_H
+#define MPS_H
+
+#include <complex>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "matrix.h"
+#include "gate_op.h"
+
+// Matrix product state: one rank-3 tensor per qubit, so memory grows linearly in the number of qubits
+// for a bounded bond dimension. Two-qubit gates are applied to neighbouring sites and split again with
+// an SVD, keeping at most max_bond singular values and dropping those below cutoff (relative to the
+// largest). Non-neighbouring gates are routed with swaps.
+class mps_state
+{
+private:
+    struct site
+    {
+        int left;
+        int right;
+        std::vector<std::complex<double>> data;  // data[(l * 2 + s) * right + r]
+    };
+
+    int qubits;
+    int max_bond;
+    double cutoff;
+    std::vector<site> sites;
+    int center;                 // Sites left of it are left-orthonormal, right of it right-orthonormal
+    double truncation_error;    // Sum of discarded squared singular values (relative weight)
+
+    void move_center(int to);
+    void apply_two_site(int q, const std::complex<double> (&g)[4][4]);  // Gate on sites q, q+1 (index s_q + 2 s_q+1)
+    void swap_sites(int q);
+    void apply_pair(int a, int b, const std::complex<double> (&g)[4][4]);  // Index bit 0 = qubit a, bit 1 = qubit b
+
+public:
+    mps_state(const std::vector<char> &initial_states, int max_bond, double cutoff);
+
+    int get_qubits() const;
+    int get_max_bond() const;  // Largest bond dimension currently in use
+    double get_truncation_error() const;
+
+    void apply_single(int qubit, const matrix &gate);
+    void apply_controlled(int control, int target, const matrix &gate);
+    void apply_gates(const std::vector<gate_op> &gates);  // Single and controlled ops (dense blocks up to 2 qubits)
+
+    matrix to_matrix() const;  // Dense (2^n x 1) statevector, only sensible for small registers
+
+    // Histogram of sampled bitstrings over the measured qubits (empty = all), highest measured qubit first
+    std::map<std::string, std::uint64_t> sample_counts(std::uint64_t shots, const std::vector<int> &measured,
+                                                       std::mt19937_64 &rng) const;
+};
+
+#endif
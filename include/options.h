@@ -0,0 +1,72 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <string>
+#include <vector>
+
+// How print_braket reports a statevector
+struct braket_format
+{
+    double epsilon = 0;          // Omit amplitudes whose magnitude is at or below epsilon
+    int top = 0;                 // Print only the top most probable terms, most probable first (0 = all)
+    bool probabilities = false;  // Print |amplitude|^2 instead of the amplitude
+
+    bool is_filtered() const { return epsilon > 0 || top > 0 || probabilities; }
+};
+
+// Command-line options controlling how the circuit is simulated
+struct sim_options
+{
+    bool split_layout = false;  // Structure-of-arrays statevector with SIMD kernels
+    bool single_precision = false;  // complex<float> amplitudes for the interleaved statevector
+    std::string isa = "auto";   // SIMD kernel set for the split layout (auto, scalar, avx2, avx512)
+    std::string backend = "auto";  // Simulation backend (auto, statevector, stabilizer, mps, mmap, sharded)
+    int max_bond = 64;             // MPS: largest bond dimension kept after each two-qubit gate
+    double mps_cutoff = 1e-12;     // MPS: singular values below this fraction of the largest are dropped
+    std::string mmap_dir;          // mmap: directory for the statevector file (empty = $TMPDIR or /tmp)
+    int chunk_qubits = 20;         // mmap: log2 of the amplitudes processed per chunk
+    int shards = 4;                // sharded: worker processes, each owning 2^n / shards amplitudes
+    int threads = 1;            // Worker threads for gate sweeps
+    bool all_inputs = false;    // Run every computational basis input as one batch
+    int fuse = 1;               // Max qubits per fused block (0 disables fusion, 1 only merges single-qubit runs)
+    bool layered = false;       // Apply the circuit one scheduled layer per cache-blocked pass instead of gate by gate
+    int shots = 0;              // Measurement samples drawn from the final state (0 = none)
+    std::vector<int> measured;  // Qubits to sample (empty = all)
+    bool fixed_seed = false;    // Use seed instead of a random device for sampling
+    unsigned long long seed = 0;
+    braket_format output;       // Output state reporting (--epsilon, --top, --probabilities)
+    std::string batch_file;     // Circuit file to run non-interactively ("-" reads stdin, empty = interactive)
+    std::string sweep_file;     // Parameter points to run every parameterised circuit of the batch at
+    std::string checkpoint_path;  // Write the final (and periodic) statevector here in binary form
+    int checkpoint_every = 0;     // Also checkpoint after every N gates of the unfused gate list (0 = only at the end)
+    std::string resume_path;      // Checkpoint to resume from, skipping the gates it already applied
+    std::string initial_state_path;  // Checkpoint whose amplitudes replace the circuit's input state
+    bool alloc_stats = false;   // Print matrix allocation counts to stderr on exit
+    std::string profile_file;   // Write a JSON phase/counter profile here on exit ("-" = stderr, empty = off)
+};
+
+enum class backend_kind { statevector, stabilizer, mps, mmap, sharded };
+
+// Registers above this size run Clifford-only circuits on the tableau when the backend is 'auto';
+// smaller ones keep the statevector so amplitudes (and their phases) can be printed
+const int stabilizer_auto_qubits = 20;
+
+// Largest register whose amplitudes the mps, mmap and sharded backends print; bigger ones print only their summary
+const int max_printed_amplitude_qubits = 20;
+
+// Largest register simulated as a statevector; 'auto' moves bigger non-Clifford circuits to the MPS
+const int max_statevector_qubits = 30;
+
+// Largest register for --all-inputs, which holds 2^n inputs of 2^n amplitudes (16 MiB per copy at this size)
+const int max_all_inputs_qubits = 10;
+
+// Resolves the --backend choice for a circuit; circuits with ch or rotations never run on the tableau
+backend_kind resolve_backend(const sim_options &options, int qubits, bool clifford);
+
+// Largest register the selected backend accepts; runs that may need the statevector are held to its limit
+int max_backend_qubits(const sim_options &options);
+
+sim_options parse_options(int argc, char* argv[]);
+void print_usage(const char* program);
+
+#endif
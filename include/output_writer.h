@@ -0,0 +1,31 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Buffered writer for large state dumps: tokens are formatted into one large buffer that is handed to the
+// stream in big blocks, instead of one formatted stream insertion per token
+class output_writer
+{
+private:
+    std::ostream &os;
+    std::vector<char> buffer;
+    std::size_t used {0};
+
+public:
+    explicit output_writer(std::ostream &os, std::size_t capacity = std::size_t{1} << 20);
+    ~output_writer();  // Flushes what is left
+    output_writer(const output_writer&) = delete;
+    output_writer& operator=(const output_writer&) = delete;
+
+    void put(char c);
+    void put(const char* text);
+    void put(const std::string &text);
+    void put_number(double value, int precision);  // Same digits as a stream with setprecision(precision)
+    void flush();
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <iostream>
+
+// Opt-in run profile: wall-clock time per phase and work counters, written as JSON by --profile.
+// Everything is a no-op until start() is called, so the disabled cost is one flag test per hook.
+namespace profile
+{
+
+enum phase { none, input, gate_construction, scheduling, simulation, sampling, output, phase_count };
+
+extern bool active;
+
+inline bool enabled() {
+    return active;
+}
+
+void start();  // Enables profiling and resets every timer and counter
+void write_report(std::ostream &os);
+
+// Charges the enclosing code to a phase. Nested scopes pause the outer phase, so each phase
+// reports its own (exclusive) time and the phases add up to the instrumented wall time.
+class scope
+{
+private:
+    phase previous;
+    bool running;
+
+public:
+    explicit scope(phase p);
+    ~scope();
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+};
+
+// Work counters, only touched from the thread driving the simulation
+struct counters
+{
+    std::uint64_t gates_applied;
+    std::uint64_t bytes_touched;  // Estimated amplitude bytes read plus written
+    std::uint64_t flops;          // Estimated real floating-point operations
+};
+
+extern counters totals;
+
+inline void count_work(std::uint64_t gates, std::uint64_t bytes, std::uint64_t flops) {
+    if (active) {
+        totals.gates_applied += gates;
+        totals.bytes_touched += bytes;
+        totals.flops += flops;
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "matrix.h"
+
+// Samples measurement outcomes of a statevector, optionally marginalised onto a subset of qubits.
+// Outcome bit j is the result of measured qubit j (sorted ascending, so bit 0 is the lowest measured qubit).
+class sampler
+{
+private:
+    std::vector<int> measured;
+    std::vector<double> threshold;     // Alias table: keep bin b with probability threshold[b],
+    std::vector<std::uint32_t> alias;  // otherwise return alias[b]
+
+    void build_alias(std::vector<double> &probabilities);
+
+public:
+    // Builds the (marginal) distribution in one pass over the amplitudes; an empty list measures every qubit
+    sampler(const matrix &state, const std::vector<int> &qubits);
+
+    const std::vector<int>& get_measured() const;
+    std::size_t get_outcomes() const;
+
+    std::uint32_t sample(std::mt19937_64 &rng) const;  // O(1) per shot
+    std::vector<std::uint64_t> sample_counts(std::uint64_t shots, std::mt19937_64 &rng) const;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef SHARDED_STATEVECTOR_H
+#define SHARDED_STATEVECTOR_H
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "matrix.h"
+#include "gate_op.h"
+#include "chunk_kernels.h"
+
+// Statevector split across local worker processes so each sweeps its own memory: 2^s shards of 2^(n-s)
+// amplitudes, each in its own POSIX shared memory segment. Stored bits below n-s are local to a shard and
+// the top s bits select the shard. apply_gates plans the gate list into runs of shard-local gates
+// separated by qubit swaps, then forks one worker per shard to execute the plan; a swap between a global
+// and a local bit is a pairwise exchange of half of each partner shard, with a coordinator barrier before
+// and after it.
+class sharded_statevector
+{
+private:
+    int qubits;
+    int shard_bits;    // s
+    int local_qubits;  // n - s
+    std::size_t shard_size;
+    int threads_per_shard;
+    std::vector<std::complex<double>*> shards;
+    qubit_layout layout;
+    std::uint64_t gate_runs {0};
+    std::uint64_t exchanges {0};
+
+public:
+    // Register in the basis state given by initial_states ('0'/'1' per qubit), split into shards (a power of two) processes,
+    // each sweeping its shard with threads_per_shard threads
+    sharded_statevector(const std::vector<char> &initial_states, int shards, int threads_per_shard);
+    ~sharded_statevector();
+    sharded_statevector(sharded_statevector &&other) noexcept;
+    sharded_statevector(const sharded_statevector&) = delete;
+    sharded_statevector& operator=(const sharded_statevector&) = delete;
+    sharded_statevector& operator=(sharded_statevector&&) = delete;
+
+    int get_qubits() const;
+    int get_shards() const;
+    std::uint64_t get_gate_runs() const;  // Runs of gates applied by every shard independently
+    std::uint64_t get_exchanges() const;  // Global-local qubit swaps between partner shards
+
+    void apply_gates(const std::vector<gate_op> &gates);
+
+    matrix to_matrix() const;  // Dense (2^n x 1) statevector in logical order
+
+    // Histogram of sampled bitstrings over the measured qubits (empty = all), highest measured qubit first
+    std::map<std::string, std::uint64_t> sample_counts(std::uint64_t shots, const std::vector<int> &measured,
+                                                       std::mt19937_64 &rng) const;
+};
+
+// Largest shard count and register accepted by the sharded backend
+const int max_shards = 64;
+const int max_sharded_qubits = 36;
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+#include "matrix.h"
+
+// Gate kernels for split (structure-of-arrays) statevectors, with runtime CPU dispatch
+namespace simd
+{
+    enum class isa { scalar, avx2, avx512 };
+
+    // 2x2 gate with real and imaginary parts stored separately (order: u00, u01, u10, u11)
+    struct gate2
+    {
+        double re[4];
+        double im[4];
+    };
+
+    gate2 make_gate2(const matrix &gate);
+
+    isa detect();  // Best instruction set supported by this CPU
+    isa active();  // Instruction set currently used by the kernels
+    void set_isa(isa target);  // Force a kernel set (clamped to what the CPU supports)
+    const char* isa_name(isa target);
+
+    // Updates amplitude pairs (i, i + stride) for i in [first, first + len)
+    void update_pairs(double* re, double* im, std::size_t first, std::size_t stride, std::size_t len, const gate2 &u);
+
+    // Gate updates over a range of work items: pair indices [begin, end) for single-qubit gates,
+    // and indices of the 2^(n-2) control-set/target-clear amplitudes for controlled gates
+    void apply_single(double* re, double* im, int qubit, std::size_t begin, std::size_t end, const gate2 &u);
+    void apply_controlled(double* re, double* im, int control, int target, std::size_t begin, std::size_t end, const gate2 &u);
+}
+
+#endif
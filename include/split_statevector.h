@@ -0,0 +1,39 @@
+#ifndef SPLIT_STATEVECTOR_H
+#define SPLIT_STATEVECTOR_H
+
+#include <vector>
+#include <cstddef>
+#include "matrix.h"
+#include "simd_kernels.h"
+#include "gate_op.h"
+
+// Statevector with real and imaginary parts in separate arrays (structure-of-arrays layout)
+class split_statevector
+{
+private:
+    std::vector<double> real_parts;
+    std::vector<double> imag_parts;
+    int qubits;
+    std::vector<double> dense_re;  // apply_dense scratch, reused so steady-state gates do not allocate
+    std::vector<double> dense_im;
+    std::vector<std::size_t> dense_offsets;
+    std::vector<int> dense_sorted;
+
+public:
+    split_statevector(const matrix &input);  // Build from a (2^n x 1) column vector
+
+    int get_qubits() const;
+    std::size_t get_size() const;
+    double* real_data();
+    double* imag_data();
+
+    // Gate application (dispatched to the best SIMD kernels for this CPU)
+    void apply_single(int qubit, const matrix &gate, gate_structure structure = gate_structure::dense);
+    void apply_controlled(int control, int target, const matrix &gate, gate_structure structure = gate_structure::dense);
+    void apply_diagonal(const std::vector<diagonal_factor> &factors);  // Batch of diagonal gates in one sweep
+    void apply_dense(const gate_qubits &targets, const matrix &block);  // 2^k x 2^k block, targets[j] is bit j
+
+    matrix to_matrix() const;
+};
+
+#endif
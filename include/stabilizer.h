@@ -0,0 +1,65 @@
+#ifndef STABILIZER_H
+#define STABILIZER_H
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "component.h"
+
+// Aaronson-Gottesman stabilizer tableau. Rows 0..n-1 are destabilizers, n..2n-1 stabilizers and 2n is
+// scratch space. Each row stores its X and Z bits packed into 64-bit words (bit q = qubit q) plus a sign,
+// so row products cost O(n/64) word operations and a measurement O(n^2/64).
+class stabilizer_tableau
+{
+private:
+    int qubits;
+    std::size_t words;            // 64-bit words per row
+    std::vector<std::uint64_t> xs;  // (2n + 1) rows of 'words' words each
+    std::vector<std::uint64_t> zs;
+    std::vector<std::uint8_t> signs;  // 1 = negative
+
+    std::uint64_t* x_row(std::size_t row) { return xs.data() + row * words; }
+    std::uint64_t* z_row(std::size_t row) { return zs.data() + row * words; }
+    const std::uint64_t* x_row(std::size_t row) const { return xs.data() + row * words; }
+    const std::uint64_t* z_row(std::size_t row) const { return zs.data() + row * words; }
+    bool x_bit(std::size_t row, int q) const { return (x_row(row)[q >> 6] >> (q & 63)) & 1; }
+    bool z_bit(std::size_t row, int q) const { return (z_row(row)[q >> 6] >> (q & 63)) & 1; }
+
+    void check_qubit(int q) const;
+    void rowsum(std::size_t h, std::size_t i);  // Row h becomes row h times row i
+    void copy_row(std::size_t to, std::size_t from);
+    void clear_row(std::size_t row);
+    void support(std::vector<std::uint64_t> &offset, std::vector<std::vector<std::uint64_t>> &basis) const;
+
+public:
+    // Basis state with initial_states[q] ('0' or '1') on qubit q
+    explicit stabilizer_tableau(const std::vector<char> &initial_states);
+
+    int get_qubits() const;
+
+    void apply_h(int q);
+    void apply_s(int q);
+    void apply_sdg(int q);
+    void apply_x(int q);
+    void apply_y(int q);
+    void apply_z(int q);
+    void apply_cx(int control, int target);
+    void apply_cy(int control, int target);
+    void apply_cz(int control, int target);
+    void apply(const component &comp);  // Library gate from the circuit IR, throws for ch and rotations
+
+    int measure(int q, std::mt19937_64 &rng);  // Collapses the state and returns the outcome
+
+    // Stabilizer generators as signed Pauli strings, highest qubit first (e.g. "+XXI")
+    std::vector<std::string> get_stabilizers() const;
+
+    // Histogram of sampled bitstrings over the measured qubits (empty = all), highest measured qubit first.
+    // Outcomes of a stabilizer state are uniform over an affine subspace, so the subspace is found once
+    // and each shot is a random combination of its basis vectors.
+    std::map<std::string, std::uint64_t> sample_counts(std::uint64_t shots, const std::vector<int> &measured,
+                                                       std::mt19937_64 &rng) const;
+};
+
+#endif
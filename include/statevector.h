@@ -0,0 +1,48 @@
+#ifndef STATEVECTOR_H
+#define STATEVECTOR_H
+
+#include <complex>
+#include <vector>
+#include <cstddef>
+#include "matrix.h"
+#include "gate_op.h"
+
+// Register state stored as 2^n amplitudes, updated in place one gate at a time. T is the scalar type of
+// the amplitudes: float halves the memory of the register and doubles the lanes per SIMD register.
+// Gate matrices stay in double and are rounded once per gate. Instantiated for float and double.
+template <typename T>
+class basic_statevector
+{
+private:
+    std::vector<std::complex<T>> amplitudes;
+    int qubits;
+    std::vector<T> dense_re;  // apply_dense scratch, reused so steady-state gates do not allocate
+    std::vector<T> dense_im;
+    std::vector<std::size_t> dense_offsets;
+    std::vector<int> dense_sorted;
+
+public:
+    basic_statevector(int qubits);
+    basic_statevector(const matrix &input);  // Build from a (2^n x 1) column vector
+
+    int get_qubits() const;
+    std::size_t get_size() const;
+    std::complex<T>* data();
+    const std::complex<T>* data() const;
+
+    // Gate application
+    void apply_single(int qubit, const matrix &gate, gate_structure structure = gate_structure::dense);
+    void apply_controlled(int control, int target, const matrix &gate, gate_structure structure = gate_structure::dense);
+    void apply_diagonal(const std::vector<diagonal_factor> &factors);  // Batch of diagonal gates in one sweep
+    void apply_dense(const gate_qubits &targets, const matrix &block);  // 2^k x 2^k block, targets[j] is bit j
+    // Gates on distinct qubits in one cache-blocked pass per 2^12 amplitude tile's worth of mixed qubits
+    void apply_layer(const std::vector<gate_op> &gates);
+    void apply_matrix(const matrix &op);  // Dense (2^n x 2^n) operator on the whole register
+
+    matrix to_matrix() const;  // Widened to double
+};
+
+typedef basic_statevector<double> statevector;
+typedef basic_statevector<float> statevector_single;
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+// Fixed set of worker threads reused for every parallel sweep
+class thread_pool
+{
+private:
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable start_signal;
+    std::condition_variable done_signal;
+    const std::function<void(std::size_t, std::size_t)>* task {nullptr};
+    std::size_t task_count {0};
+    std::size_t chunk_size {0};
+    unsigned long generation {0};
+    int pending {0};
+    bool stopping {false};
+
+    void worker_loop(int id);
+    void run_chunk(int id);
+
+public:
+    explicit thread_pool(int threads);
+    ~thread_pool();
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    int get_threads() const;
+
+    // Splits [0, count) into one contiguous chunk per thread, with chunk boundaries on multiples of grain.
+    // Called from inside a running task (e.g. a gate sweep within a parallel parameter sweep) it runs inline.
+    void parallel_for(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)> &body);
+
+    // Process-wide pool used by the simulation engines (nullptr when running single-threaded)
+    static thread_pool* shared();
+    static void configure_shared(int threads);
+    static void forget_shared();  // In a forked child: drops the pool without joining threads that were not copied
+};
+
+// Registers below this many work items are swept on the calling thread (wake-up cost dominates)
+const std::size_t parallel_threshold = std::size_t{1} << 13;
+// Work items per grain; 64 amplitude pairs keeps chunk edges on cache-line boundaries
+const std::size_t sweep_grain = 64;
+
+// Runs body over [0, count) on the shared pool, or inline for small counts and single-threaded runs. The
+// inline path calls body directly, so small sweeps never wrap it in a heap-allocated std::function.
+template <typename Body>
+void parallel_sweep(std::size_t count, const Body &body) {
+    thread_pool* pool = thread_pool::shared();
+    if (pool != nullptr && count >= parallel_threshold) {
+        pool->parallel_for(count, sweep_grain, body);
+    } else {
+        body(0, count);
+    }
+}
+
+#endif
@@ -7,16 +7,95 @@
 #include<bitset>
 #include<stdexcept>
 #include<limits>
+#include<fstream>
 #include"complex.h"
 #include"matrix.h"
 #include"component.h"
 #include"circuit.h"
 #include"input_handler.h"
+#include"options.h"
+#include"simd_kernels.h"
+#include"thread_pool.h"
+#include"circuit_file.h"
+#include"profiler.h"
+
+// Prints the matrix allocation counters for --alloc-stats and the --profile report
+static void report_allocations(const sim_options &options) {
+    if (options.alloc_stats) {
+        matrix_alloc_stats stats = get_matrix_alloc_stats();
+        std::cerr << "matrix allocations: " << stats.allocations << " heap (" << stats.bytes << " bytes), "
+                  << stats.reuses << " reused from arena" << std::endl;
+    }
+    if (options.profile_file == "-") {
+        profile::write_report(std::cerr);
+    } else if (!options.profile_file.empty()) {
+        std::ofstream file{options.profile_file};
+        if (!file) {
+            std::cerr << "Error: Cannot write " << options.profile_file << std::endl;
+            return;
+        }
+        profile::write_report(file);
+    }
+}
 
 // Main function
-int main() {
-    // Get the number of qubits from the user
-    int qubits = get_qubits_from_user();
+int main(int argc, char* argv[]) {
+    // Parse command-line options
+    sim_options options;
+    try {
+        options = parse_options(argc, argv);
+    } catch (const std::invalid_argument& e) {
+        std::cout << "Error: " << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (options.isa == "scalar") {
+        simd::set_isa(simd::isa::scalar);
+    } else if (options.isa == "avx2") {
+        simd::set_isa(simd::isa::avx2);
+    } else if (options.isa == "avx512") {
+        simd::set_isa(simd::isa::avx512);
+    }
+    thread_pool::configure_shared(options.threads);
+    matrix_arena arena;  // Recycle matrix temporaries for the whole run
+    if (!options.profile_file.empty()) {
+        profile::start();
+    }
+
+    // Non-interactive mode: simulate every circuit in the given file
+    if (!options.batch_file.empty()) {
+        std::ios::sync_with_stdio(false);
+        std::vector<parameter_point> points;
+        if (!options.sweep_file.empty()) {
+            std::ifstream sweep{options.sweep_file};
+            if (!sweep) {
+                std::cout << "Error: Cannot open " << options.sweep_file << std::endl;
+                return 1;
+            }
+            try {
+                points = read_sweep_points(sweep);
+            } catch (const std::runtime_error& e) {
+                std::cout << "Error: " << e.what() << std::endl;
+                return 1;
+            }
+        }
+        int failures = 0;
+        if (options.batch_file == "-") {
+            failures = run_batch(std::cin, options, points);
+        } else {
+            std::ifstream file{options.batch_file};
+            if (!file) {
+                std::cout << "Error: Cannot open " << options.batch_file << std::endl;
+                return 1;
+            }
+            failures = run_batch(file, options, points);
+        }
+        report_allocations(options);
+        return failures == 0 ? 0 : 1;
+    }
+
+    // Get the number of qubits from the user, up to what the selected backend can hold
+    int qubits = get_qubits_from_user(max_backend_qubits(options));
     
     // Output warning if number of qubits is high
     if (qubits > 8) {
@@ -30,27 +109,54 @@ int main() {
         }
     }
 
-    // Get initial states of each qubit from the user
-    std::vector<char> initial_states = get_initial_states_from_user(qubits);
-    matrix input_vector = get_input_vector(initial_states);  // Assuming you have this function somewhere
+    // The dense input and live output state are only kept when a general circuit of this size runs on the
+    // statevector; the other backends start from the initial states. When the statevector would be needed
+    // but cannot hold the register (--backend stabilizer), only Clifford gates are offered.
+    const bool dense = resolve_backend(options, qubits, false) == backend_kind::statevector && qubits <= max_statevector_qubits;
+    const bool clifford_only = !dense && resolve_backend(options, qubits, false) == backend_kind::statevector;
+
+    // Get initial states of each qubit from the user (not needed when running every basis input or loading a saved state)
+    const bool saved_input = !options.initial_state_path.empty();
+    std::vector<char> initial_states = (options.all_inputs || saved_input) ? std::vector<char>(qubits, '0')
+                                                                           : get_initial_states_from_user(qubits);
+    matrix input_vector;
+    if (dense) {
+        try {
+            input_vector = saved_input ? load_input_vector(options.initial_state_path, qubits) : get_input_vector(initial_states);
+        } catch (const std::exception& e) {
+            std::cout << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
 
     // Predefined component library
-    std::vector<std::string> comp_library = {"x", "y", "z", "h", "cx", "cy", "cz", "ch"};
+    std::vector<std::string> comp_library;
+    for (const char* name : {"x", "y", "z", "h", "cx", "cy", "cz", "ch",
+                             "rx", "ry", "rz", "phase", "crx", "cry", "crz", "cphase"}) {
+        if (!clifford_only || find_gate_info(name)->clifford) {
+            comp_library.push_back(name);
+        }
+    }
     print_library(comp_library);
 
     // Create circuit
-    circuit c{qubits, input_vector, initial_states};  // Assuming circuit class is defined
+    circuit c = dense ? circuit{qubits, input_vector, initial_states} : circuit{qubits, initial_states};
 
     // Add components to the circuit
-    std::vector<component*> comp_added;
-    add_components(c, comp_added, comp_library, qubits);
-
-    calculate_and_display_results(c, input_vector);
+    add_components(c, comp_library, qubits);
 
-    // Clean up memory (delete components)
-    for (component* comp : comp_added) {
-        delete comp;
+    try {
+        if (options.all_inputs) {
+            calculate_and_display_batch_results(c, qubits, options);
+        } else {
+            calculate_and_display_results(c, input_vector, options);
+        }
+    } catch (const std::exception& e) {  // Unreadable checkpoints, out-of-core file errors
+        std::cout << "Error: " << e.what() << std::endl;
+        report_allocations(options);
+        return 1;
     }
-    
+
+    report_allocations(options);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "batch_statevector.h"
+#include <stdexcept>
+#include <algorithm>
+#include "thread_pool.h"
+
+// Returns k with a zero bit inserted at position bit (higher bits shifted up)
+static inline std::size_t insert_zero_bit(std::size_t k, int bit) {
+    std::size_t low_mask = (std::size_t{1} << bit) - 1;
+    return ((k & ~low_mask) << 1) | (k & low_mask);
+}
+
+// Constructor from a list of column vectors of equal size
+batch_statevector::batch_statevector(const std::vector<matrix> &inputs) : qubits{0}, batch{inputs.size()} {
+    if (inputs.empty()) {
+        throw std::invalid_argument("Batch must contain at least one input.");
+    }
+    const int rows = inputs[0].get_rows();
+    while ((1 << qubits) < rows) {
+        qubits++;
+    }
+    if ((1 << qubits) != rows) {
+        throw std::invalid_argument("Input vector size must be a power of 2.");
+    }
+    amplitudes.resize(static_cast<std::size_t>(rows) * batch);
+    for (std::size_t b = 0; b < batch; b++) {
+        if (inputs[b].get_rows() != rows || inputs[b].get_cols() != 1) {
+            throw std::invalid_argument("Batch inputs must be column vectors of equal size.");
+        }
+        for (int i = 0; i < rows; i++) {
+            amplitudes[i * batch + b] = inputs[b].at(i, 0);
+        }
+    }
+}
+
+// Accessors
+int batch_statevector::get_qubits() const {
+    return qubits;
+}
+
+std::size_t batch_statevector::get_batch_size() const {
+    return batch;
+}
+
+std::size_t batch_statevector::get_size() const {
+    return amplitudes.size();
+}
+
+// Row updates: (row0, row1) <- 2x2 gate applied across all batch members, real arithmetic so the loop vectorises
+static void update_rows(double* row0, double* row1, std::size_t batch, const std::complex<double> u[4]) {
+    const double u00r = u[0].real(), u00i = u[0].imag(), u01r = u[1].real(), u01i = u[1].imag();
+    const double u10r = u[2].real(), u10i = u[2].imag(), u11r = u[3].real(), u11i = u[3].imag();
+    for (std::size_t j = 0; j < 2 * batch; j += 2) {
+        const double ar0 = row0[j], ai0 = row0[j + 1];
+        const double ar1 = row1[j], ai1 = row1[j + 1];
+        row0[j] = u00r * ar0 - u00i * ai0 + u01r * ar1 - u01i * ai1;
+        row0[j + 1] = u00r * ai0 + u00i * ar0 + u01r * ai1 + u01i * ar1;
+        row1[j] = u10r * ar0 - u10i * ai0 + u11r * ar1 - u11i * ai1;
+        row1[j + 1] = u10r * ai0 + u10i * ar0 + u11r * ai1 + u11i * ar1;
+    }
+}
+
+// Multiplies a row by a phase (sign flips and swaps for unit phases)
+static void scale_row(std::complex<double>* row, std::size_t batch, std::complex<double> phase) {
+    phase_kind kind = classify_phase(phase);
+    if (kind == phase_one) {
+        return;
+    }
+    for (std::size_t j = 0; j < batch; j++) {
+        row[j] = apply_phase(kind, phase, row[j]);
+    }
+}
+
+// Applies a 2x2 gate to the row pairs (i, i + stride) selected by the work items
+static void apply_rows(std::complex<double>* amp, std::size_t batch, std::size_t count, std::size_t stride,
+                       int low, int high, std::size_t set_bits, const matrix &gate, gate_structure structure) {
+    const std::complex<double> zero{0, 0};
+    std::complex<double> u[4] = {gate.get_value(1, 1), gate.get_value(1, 2), gate.get_value(2, 1), gate.get_value(2, 2)};
+    const bool diagonal = structure == gate_structure::diagonal && u[1] == zero && u[2] == zero;
+    const bool antidiagonal = (structure == gate_structure::permutation || structure == gate_structure::phase_permutation)
+                              && u[0] == zero && u[3] == zero;
+    parallel_sweep(count, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; k++) {
+            std::size_t i = insert_zero_bit(k, low);
+            if (high >= 0) {
+                i = insert_zero_bit(i, high);
+            }
+            i |= set_bits;
+            std::complex<double>* row0 = amp + i * batch;
+            std::complex<double>* row1 = amp + (i + stride) * batch;
+            if (diagonal) {
+                scale_row(row0, batch, u[0]);
+                scale_row(row1, batch, u[3]);
+            } else if (antidiagonal) {
+                std::swap_ranges(row0, row0 + batch, row1);
+                scale_row(row0, batch, u[1]);
+                scale_row(row1, batch, u[2]);
+            } else {
+                update_rows(reinterpret_cast<double*>(row0), reinterpret_cast<double*>(row1), batch, u);
+            }
+        }
+    });
+}
+
+void batch_statevector::apply_single(int qubit, const matrix &gate, gate_structure structure) {
+    if (qubit < 0 || qubit >= qubits) {
+        throw std::out_of_range("Qubit index out of range.");
+    }
+    std::size_t rows = std::size_t{1} << qubits;
+    apply_rows(amplitudes.data(), batch, rows >> 1, std::size_t{1} << qubit, qubit, -1, 0, gate, structure);
+}
+
+void batch_statevector::apply_controlled(int control, int target, const matrix &gate, gate_structure structure) {
+    if (control < 0 || control >= qubits || target < 0 || target >= qubits || control == target) {
+        throw std::out_of_range("Invalid control/target qubits.");
+    }
+    std::size_t rows = std::size_t{1} << qubits;
+    apply_rows(amplitudes.data(), batch, rows >> 2, std::size_t{1} << target, std::min(control, target),
+               std::max(control, target), std::size_t{1} << control, gate, structure);
+}
+
+// Dense block: for each base index, the 2^k selected rows are replaced by block * rows
+void batch_statevector::apply_dense(const gate_qubits &targets, const matrix &block) {
+    const int k = static_cast<int>(targets.size());
+    const int dim = 1 << k;
+    if (k < 1 || k > max_dense_qubits || k > qubits || block.get_rows() != dim || block.get_cols() != dim) {
+        throw std::invalid_argument("Invalid dense block.");
+    }
+    std::vector<int> sorted(targets.begin(), targets.end());
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end() || sorted.front() < 0 || sorted.back() >= qubits) {
+        throw std::out_of_range("Invalid block qubits.");
+    }
+    std::vector<std::size_t> offsets(dim, 0);
+    for (int l = 0; l < dim; l++) {
+        for (int j = 0; j < k; j++) {
+            if ((l >> j) & 1) {
+                offsets[l] |= std::size_t{1} << targets[j];
+            }
+        }
+    }
+    std::complex<double>* amp = amplitudes.data();
+    const std::size_t rows = std::size_t{1} << qubits;
+    parallel_sweep(rows >> k, [&](std::size_t begin, std::size_t end) {
+        std::vector<std::complex<double>> in(dim * batch);
+        for (std::size_t b = begin; b < end; b++) {
+            std::size_t base = b;
+            for (int j = 0; j < k; j++) {
+                base = insert_zero_bit(base, sorted[j]);
+            }
+            for (int l = 0; l < dim; l++) {
+                std::copy(amp + (base + offsets[l]) * batch, amp + (base + offsets[l] + 1) * batch, in.begin() + l * batch);
+            }
+            for (int r = 0; r < dim; r++) {
+                std::complex<double>* out = amp + (base + offsets[r]) * batch;
+                std::fill(out, out + batch, std::complex<double>{0, 0});
+                for (int c = 0; c < dim; c++) {
+                    const std::complex<double> u = block.at(r, c);
+                    if (u == std::complex<double>{0, 0}) {
+                        continue;
+                    }
+                    const std::complex<double>* row = in.data() + c * batch;
+                    for (std::size_t j = 0; j < batch; j++) {
+                        out[j] += u * row[j];
+                    }
+                }
+            }
+        }
+    });
+}
+
+// Diagonal batch: each row's total phase is computed once and applied to all batch members
+void batch_statevector::apply_diagonal(const std::vector<diagonal_factor> &factors) {
+    if (factors.empty()) {
+        return;
+    }
+    std::complex<double>* amp = amplitudes.data();
+    parallel_sweep(std::size_t{1} << qubits, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            std::complex<double> phase{1, 0};
+            for (const diagonal_factor& factor : factors) {
+                if ((i & factor.mask) == factor.value) {
+                    phase = apply_phase(factor.kind, factor.phase, phase);
+                }
+            }
+            scale_row(amp + i * batch, batch, phase);
+        }
+    });
+}
+
+matrix batch_statevector::get_state(std::size_t member) const {
+    if (member >= batch) {
+        throw std::out_of_range("Batch member out of range.");
+    }
+    const int rows = 1 << qubits;
+    matrix output{rows, 1};
+    for (int i = 0; i < rows; i++) {
+        output.at(i, 0) = amplitudes[i * batch + member];
+    }
+    return output;
+}
+
+std::vector<matrix> batch_statevector::to_matrices() const {
+    std::vector<matrix> outputs;
+    for (std::size_t b = 0; b < batch; b++) {
+        outputs.push_back(get_state(b));
+    }
+    return outputs;
+}
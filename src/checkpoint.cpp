@@ -0,0 +1,134 @@
+#include "checkpoint.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char checkpoint_magic[8] = "QCSTATE";
+
+template <typename T>
+void write_checkpoint(const std::string &path, const std::complex<T>* amplitudes, int qubits, std::uint64_t gate_index) {
+    checkpoint_header header;
+    std::memcpy(header.magic, checkpoint_magic, sizeof(header.magic));
+    header.version = checkpoint_version;
+    header.qubits = static_cast<std::uint32_t>(qubits);
+    header.precision = sizeof(T);
+    header.reserved = 0;
+    header.gate_index = gate_index;
+
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+        if (!file) {
+            throw std::runtime_error("Cannot write checkpoint " + temporary);
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(amplitudes), sizeof(std::complex<T>) << qubits);
+        if (!file.flush()) {
+            throw std::runtime_error("Cannot write checkpoint " + temporary);
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot rename checkpoint to " + path + ": " + std::strerror(errno));
+    }
+}
+
+template void write_checkpoint<double>(const std::string&, const std::complex<double>*, int, std::uint64_t);
+template void write_checkpoint<float>(const std::string&, const std::complex<float>*, int, std::uint64_t);
+
+checkpoint_file::checkpoint_file(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open checkpoint " + path + ": " + std::strerror(errno));
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(header)) {
+        close(fd);
+        throw std::runtime_error("Checkpoint " + path + " is truncated.");
+    }
+    mapped_bytes = static_cast<std::size_t>(info.st_size);
+    mapped = mmap(nullptr, mapped_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping keeps the file alive
+    if (mapped == MAP_FAILED) {
+        mapped = nullptr;
+        throw std::runtime_error("Cannot map checkpoint " + path + ": " + std::strerror(errno));
+    }
+    std::memcpy(&header, mapped, sizeof(header));
+
+    std::string error;
+    if (std::memcmp(header.magic, checkpoint_magic, sizeof(header.magic)) != 0) {
+        error = " is not a statevector checkpoint.";
+    } else if (header.version != checkpoint_version) {
+        error = " has unsupported version " + std::to_string(header.version) + ".";
+    } else if (header.qubits < 1 || header.qubits > 40 || (header.precision != 4 && header.precision != 8)) {
+        error = " has a corrupt header.";
+    } else if (mapped_bytes != sizeof(header) + (std::size_t{2} * header.precision << header.qubits)) {
+        error = " does not match its qubit count.";
+    }
+    if (!error.empty()) {
+        munmap(mapped, mapped_bytes);
+        mapped = nullptr;
+        throw std::runtime_error("Checkpoint " + path + error);
+    }
+    madvise(mapped, mapped_bytes, MADV_SEQUENTIAL);
+}
+
+checkpoint_file::~checkpoint_file() {
+    if (mapped != nullptr) {
+        munmap(mapped, mapped_bytes);
+    }
+}
+
+// Accessors
+int checkpoint_file::get_qubits() const {
+    return static_cast<int>(header.qubits);
+}
+
+std::size_t checkpoint_file::get_size() const {
+    return std::size_t{1} << header.qubits;
+}
+
+bool checkpoint_file::is_single() const {
+    return header.precision == sizeof(float);
+}
+
+std::uint64_t checkpoint_file::get_gate_index() const {
+    return header.gate_index;
+}
+
+template <typename T>
+void checkpoint_file::copy_to(std::complex<T>* out) const {
+    const char* payload = static_cast<const char*>(mapped) + sizeof(header);
+    const std::size_t size = get_size();
+    if (header.precision == sizeof(T)) {
+        std::memcpy(out, payload, size * sizeof(std::complex<T>));
+    } else if (is_single()) {
+        const std::complex<float>* in = reinterpret_cast<const std::complex<float>*>(payload);
+        for (std::size_t i = 0; i < size; i++) {
+            out[i] = std::complex<T>(in[i]);
+        }
+    } else {
+        const std::complex<double>* in = reinterpret_cast<const std::complex<double>*>(payload);
+        for (std::size_t i = 0; i < size; i++) {
+            out[i] = std::complex<T>(in[i]);
+        }
+    }
+}
+
+template void checkpoint_file::copy_to<double>(std::complex<double>*) const;
+template void checkpoint_file::copy_to<float>(std::complex<float>*) const;
+
+matrix checkpoint_file::to_matrix() const {
+    if (header.qubits > 30) {
+        throw std::invalid_argument("Checkpoint too large to load as a dense matrix.");
+    }
+    const int rows = static_cast<int>(get_size());
+    matrix output{rows, 1};
+    copy_to(output.data());
+    return output;
+}
@@ -0,0 +1,316 @@
+#include "chunk_kernels.h"
+#include <algorithm>
+#include <stdexcept>
+#include "thread_pool.h"
+
+// Gates looked at when choosing which low qubit to move out of the chunk
+static const std::size_t lookahead_gates = 1024;
+
+// Returns k with a zero bit inserted at position bit (higher bits shifted up)
+static inline std::size_t insert_zero_bit(std::size_t k, int bit) {
+    std::size_t low_mask = (std::size_t{1} << bit) - 1;
+    return ((k & ~low_mask) << 1) | (k & low_mask);
+}
+
+// Complex product without the NaN/infinity recovery of operator*, which dominates the streaming kernels
+static inline std::complex<double> multiply(std::complex<double> a, std::complex<double> b) {
+    return std::complex<double>{a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+qubit_layout::qubit_layout(int qubits, int chunk_qubits) : chunk_qubits{chunk_qubits} {
+    for (int q = 0; q < qubits; q++) {
+        position.push_back(q);
+        logical_at.push_back(q);
+    }
+}
+
+int qubit_layout::get_chunk_qubits() const {
+    return chunk_qubits;
+}
+
+int qubit_layout::stored_bit(int qubit) const {
+    return position[qubit];
+}
+
+bool qubit_layout::is_local(const gate_op &op) const {
+    if (op.structure == gate_structure::diagonal) {
+        return true;
+    }
+    if (op.kind == gate_op::controlled) {
+        return position[op.qubits[1]] < chunk_qubits;
+    }
+    for (int q : op.qubits) {
+        if (position[q] >= chunk_qubits) {
+            return false;
+        }
+    }
+    return true;
+}
+
+gate_op qubit_layout::to_stored(const gate_op &op) const {
+    gate_op stored = op;
+    for (std::int32_t& q : stored.qubits) {
+        q = position[q];
+    }
+    return stored;
+}
+
+std::vector<std::pair<int, int>> qubit_layout::make_local(const gate_op &op, const std::vector<gate_op> &gates, std::size_t next) {
+    // A controlled gate only needs its target in the chunk
+    const std::int32_t* needed = op.qubits.begin() + (op.kind == gate_op::controlled ? 1 : 0);
+    std::vector<std::pair<int, int>> swaps;
+    for (; needed != op.qubits.end(); ++needed) {
+        const int q = *needed;
+        if (position[q] < chunk_qubits) {
+            continue;
+        }
+        int victim = -1;
+        std::size_t victim_distance = 0;
+        for (int bit = 0; bit < chunk_qubits; bit++) {
+            const int candidate = logical_at[bit];
+            if (std::find(op.qubits.begin(), op.qubits.end(), candidate) != op.qubits.end()) {
+                continue;
+            }
+            std::size_t distance = 0;
+            const std::size_t end = std::min(gates.size(), next + lookahead_gates);
+            while (next + distance < end) {
+                const gate_qubits& used = gates[next + distance].qubits;
+                if (std::find(used.begin(), used.end(), candidate) != used.end()) {
+                    break;
+                }
+                distance++;
+            }
+            if (victim < 0 || distance > victim_distance) {
+                victim = bit;
+                victim_distance = distance;
+            }
+        }
+        const int high = position[q];
+        swaps.emplace_back(high, victim);
+        const int evicted = logical_at[victim];
+        std::swap(logical_at[high], logical_at[victim]);
+        position[q] = victim;
+        position[evicted] = high;
+    }
+    return swaps;
+}
+
+// Stored position of a logical basis index
+std::size_t qubit_layout::stored_index(std::size_t logical_index) const {
+    std::size_t stored = 0;
+    for (std::size_t q = 0; q < position.size(); q++) {
+        if ((logical_index >> q) & 1) {
+            stored |= std::size_t{1} << position[q];
+        }
+    }
+    return stored;
+}
+
+chunk_program::chunk_program(const std::vector<gate_op> &stored_run, int chunk_qubits) : chunk_qubits{chunk_qubits} {
+    for (const gate_op& op : stored_run) {
+        if (op.kind == gate_op::dense && static_cast<int>(op.qubits.size()) > chunk_qubits) {
+            throw std::invalid_argument("Dense block is wider than the chunk.");
+        }
+        if (op.structure == gate_structure::diagonal) {
+            if (steps.empty() || !steps.back().diagonal) {
+                steps.push_back(step{true, op, {}});
+            }
+            append_diagonal_factors(op, steps.back().factors);
+        } else {
+            steps.push_back(step{false, op, {}});
+        }
+    }
+    gates = stored_run.size();
+}
+
+std::size_t chunk_program::get_gate_count() const {
+    return gates;
+}
+
+// 2x2 update of each pair (i, i + 2^target) in the chunk whose control bits are all set
+static void apply_pairs(std::complex<double>* amp, std::size_t len, int target, std::size_t control_mask, const matrix &gate) {
+    const std::complex<double> u00 = gate.at(0, 0), u01 = gate.at(0, 1), u10 = gate.at(1, 0), u11 = gate.at(1, 1);
+    const std::size_t stride = std::size_t{1} << target;
+    parallel_sweep(len >> 1, [=](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; k++) {
+            const std::size_t i = insert_zero_bit(k, target);
+            if ((i & control_mask) != control_mask) {
+                continue;
+            }
+            const std::complex<double> a0 = amp[i];
+            const std::complex<double> a1 = amp[i + stride];
+            amp[i] = multiply(u00, a0) + multiply(u01, a1);
+            amp[i + stride] = multiply(u10, a0) + multiply(u11, a1);
+        }
+    });
+}
+
+// Gathers the 2^k amplitudes of each block, multiplies, scatters back (targets inside the chunk)
+static void apply_block(std::complex<double>* amp, std::size_t len, const gate_qubits &targets, const matrix &block) {
+    const int k = static_cast<int>(targets.size());
+    const int dim = 1 << k;
+    std::vector<int> sorted(targets.begin(), targets.end());
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<std::size_t> offsets(dim, 0);
+    for (int l = 0; l < dim; l++) {
+        for (int j = 0; j < k; j++) {
+            if ((l >> j) & 1) {
+                offsets[l] |= std::size_t{1} << targets[j];
+            }
+        }
+    }
+    const std::size_t* offset = offsets.data();
+    const int* positions = sorted.data();
+    const std::complex<double>* u = block.data();
+    parallel_sweep(len >> k, [=](std::size_t begin, std::size_t end) {
+        std::complex<double> in[1 << max_dense_qubits];
+        for (std::size_t b = begin; b < end; b++) {
+            std::size_t base = b;
+            for (int j = 0; j < k; j++) {
+                base = insert_zero_bit(base, positions[j]);
+            }
+            for (int l = 0; l < dim; l++) {
+                in[l] = amp[base + offset[l]];
+            }
+            for (int r = 0; r < dim; r++) {
+                std::complex<double> sum{0, 0};
+                for (int c = 0; c < dim; c++) {
+                    sum += multiply(u[r * dim + c], in[c]);
+                }
+                amp[base + offset[r]] = sum;
+            }
+        }
+    });
+}
+
+// Multiplies each amplitude by its matching phases; factor masks may include bits above the chunk
+static void apply_factors(std::complex<double>* amp, std::size_t len, std::size_t base, const std::vector<diagonal_factor> &factors) {
+    const diagonal_factor* factor = factors.data();
+    const std::size_t count = factors.size();
+    parallel_sweep(len, [=](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            std::complex<double> a = amp[i];
+            for (std::size_t f = 0; f < count; f++) {
+                if (((base | i) & factor[f].mask) == factor[f].value) {
+                    a = apply_phase(factor[f].kind, factor[f].phase, a);
+                }
+            }
+            amp[i] = a;
+        }
+    });
+}
+
+void chunk_program::apply(std::complex<double>* chunk, std::size_t base) const {
+    const std::size_t len = std::size_t{1} << chunk_qubits;
+    for (const step& s : steps) {
+        if (s.diagonal) {
+            apply_factors(chunk, len, base, s.factors);
+        } else if (s.op.kind == gate_op::single) {
+            apply_pairs(chunk, len, s.op.qubits[0], 0, *s.op.m);
+        } else if (s.op.kind == gate_op::controlled) {
+            const int control = s.op.qubits[0];
+            if (control < chunk_qubits) {
+                apply_pairs(chunk, len, s.op.qubits[1], std::size_t{1} << control, *s.op.m);
+            } else if (base & (std::size_t{1} << control)) {  // Control above the chunk is fixed for it
+                apply_pairs(chunk, len, s.op.qubits[1], 0, *s.op.m);
+            }
+        } else {
+            apply_block(chunk, len, s.op.qubits, *s.op.m);
+        }
+    }
+}
+
+std::size_t basis_index(const std::vector<char> &initial_states) {
+    std::size_t index = 0;
+    for (std::size_t q = 0; q < initial_states.size(); q++) {
+        if (initial_states[q] != '0' && initial_states[q] != '1') {
+            throw std::invalid_argument("Initial states must be '0' or '1'.");
+        }
+        index |= static_cast<std::size_t>(initial_states[q] - '0') << q;
+    }
+    return index;
+}
+
+void swap_between_chunks(std::complex<double>* first, std::complex<double>* second, int low, std::size_t begin, std::size_t end) {
+    const std::size_t low_bit = std::size_t{1} << low;
+    parallel_sweep(end - begin, [=](std::size_t from, std::size_t to) {
+        for (std::size_t k = begin + from; k < begin + to; k++) {
+            const std::size_t i = insert_zero_bit(k, low);
+            std::swap(first[i | low_bit], second[i]);
+        }
+    });
+}
+
+std::map<std::string, std::uint64_t> sample_chunks(const std::vector<const std::complex<double>*> &chunks, std::size_t chunk_size,
+                                                   const qubit_layout &layout, int qubits, std::uint64_t shots,
+                                                   const std::vector<int> &measured, std::mt19937_64 &rng) {
+    std::vector<int> bits = measured;
+    if (bits.empty()) {
+        for (int q = 0; q < qubits; q++) {
+            bits.push_back(q);
+        }
+    }
+    for (int q : bits) {
+        if (q < 0 || q >= qubits) {
+            throw std::out_of_range("Measured qubit out of range.");
+        }
+    }
+    std::sort(bits.begin(), bits.end());
+
+    // Sorted uniform draws matched against the running probability in a single pass over the amplitudes
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<double> draws(shots);
+    for (double& d : draws) {
+        d = uniform(rng);
+    }
+    std::sort(draws.begin(), draws.end());
+
+    std::map<std::string, std::uint64_t> counts;
+    std::string key(bits.size(), '0');
+    auto record = [&](std::size_t stored, std::uint64_t hits) {
+        for (std::size_t j = 0; j < bits.size(); j++) {
+            key[bits.size() - 1 - j] = ((stored >> layout.stored_bit(bits[j])) & 1) ? '1' : '0';
+        }
+        counts[key] += hits;
+    };
+    std::size_t next = 0;
+    std::size_t last_nonzero = 0;
+    double cumulative = 0;
+    for (std::size_t c = 0; c < chunks.size() && next < draws.size(); c++) {
+        for (std::size_t i = 0; i < chunk_size && next < draws.size(); i++) {
+            const double p = std::norm(chunks[c][i]);
+            if (p == 0) {
+                continue;
+            }
+            const std::size_t stored = c * chunk_size + i;
+            last_nonzero = stored;
+            cumulative += p;
+            std::uint64_t hits = 0;
+            while (next < draws.size() && draws[next] < cumulative) {
+                hits++;
+                next++;
+            }
+            if (hits > 0) {
+                record(stored, hits);
+            }
+        }
+    }
+    if (next < draws.size()) {  // Rounding left the total just under 1
+        record(last_nonzero, draws.size() - next);
+    }
+    return counts;
+}
+
+matrix gather_chunks(const std::vector<const std::complex<double>*> &chunks, std::size_t chunk_size, const qubit_layout &layout,
+                     int qubits) {
+    if (qubits > 30) {
+        throw std::invalid_argument("Register too large to convert to a dense matrix.");
+    }
+    const int rows = 1 << qubits;
+    matrix output{rows, 1};
+    for (int i = 0; i < rows; i++) {
+        const std::size_t stored = layout.stored_index(i);
+        output.at(i, 0) = chunks[stored / chunk_size][stored % chunk_size];
+    }
+    return output;
+}
@@ -1,156 +1,611 @@
 #include "circuit.h"
+#include <utility>
+#include "profiler.h"
+#include "checkpoint.h"
+#include "output_writer.h"
+#include "thread_pool.h"
 
 // Destructor
-circuit::~circuit() {
-    reg.clear();
-}
+circuit::~circuit() {}
 
 // Constructor
 circuit::circuit(int qubits, matrix input, std::vector<char> initial_states) 
-    : input_vector{input}, initial_states{initial_states},qubits{qubits} {
+    : frontier(qubits), input_vector{input}, initial_states{initial_states},qubits{qubits}, dense{true}, cached_state{input}, cached_layers{0}, prepared_fuse{-1} {
     matrix_size = 1 << qubits;  // Set matrix size to (2^q) using bitshifting
 }
 
+circuit::circuit(int qubits, std::vector<char> initial_states)
+    : frontier(qubits), initial_states{initial_states}, matrix_size{0}, qubits{qubits}, dense{false}, cached_state{0}, cached_layers{0}, prepared_fuse{-1} {}
+
 // Return number of qubits in the circuit
 int circuit::get_qubits() const {
     return qubits;
 }
 
-// Add component to the circuit
-void circuit::add(component* comp) {
-    if (dynamic_cast<single_component*>(comp)) {  // Checks if component is single-qubit
-        identity* id = new identity(2);
-        std::vector<component*> comp_column;
-        for (int i = 0; i < qubits; i++) {
-            if (i == dynamic_cast<single_component*>(comp)->get_qubit()) {
-                comp_column.push_back(comp);
-            } else {
-                comp_column.push_back(id);
+bool circuit::is_dense() const {
+    return dense;
+}
+
+// Guards the methods that need the 2^n input state
+void circuit::require_dense() const {
+    if (!dense) {
+        throw std::logic_error("The circuit was built without a dense input state.");
+    }
+}
+
+std::size_t circuit::get_gate_count() const {
+    return program.size();
+}
+
+std::size_t circuit::get_depth() const {
+    return layer_start.size();
+}
+
+// Lowest qubit a component touches, which orders the gates within a layer
+static int lowest_qubit(const component &comp) {
+    return comp.qubits[1] >= 0 ? std::min(comp.qubits[0], comp.qubits[1]) : comp.qubits[0];
+}
+
+// Add component to the circuit in the earliest layer its dependencies allow
+void circuit::add(const component &comp) {
+    const std::size_t layer = schedule(comp);
+    prepared_fuse = -1;
+    if (layer == layer_start.size()) {
+        layer_start.push_back(program.size());
+        program.push_back(comp);
+    } else {
+        std::size_t slot = layer_start[layer];
+        while (slot < layer_end(layer) && lowest_qubit(program[slot]) < lowest_qubit(comp)) {
+            slot++;
+        }
+        program.insert(program.begin() + slot, comp);
+        for (std::size_t later = layer + 1; later < layer_start.size(); later++) {
+            layer_start[later]++;
+        }
+    }
+    // A gate placed inside the cached prefix commutes with every later gate it shares a qubit with, so
+    // applying it to the cached state gives exactly the new prefix output
+    if (dense && layer < cached_layers) {
+        gate_list added;
+        added.gates.push_back(to_gate_op(comp, added));
+        apply_gates(cached_state, added.gates);
+    }
+}
+
+std::size_t circuit::schedule(const component &comp) {
+    profile::scope timer{profile::scheduling};
+    const gate_info& info = get_gate_info(comp.op);
+    const int touched = info.controlled ? 2 : 1;
+    const gate_axis axes[2] = {info.controlled ? gate_axis::z : info.axis, info.axis};
+
+    // The gate joins the current run of each qubit where it commutes with that run, and then only has to
+    // follow the run before it; elsewhere it follows everything on the qubit
+    bool joins[2] = {false, false};
+    int bound = -1;
+    for (int s = 0; s < touched; s++) {
+        const qubit_frontier& f = frontier[comp.qubits[s]];
+        joins[s] = axes[s] != gate_axis::none && axes[s] == f.axis;
+        bound = std::max(bound, joins[s] ? f.before : f.last);
+    }
+    int layer = bound + 1;
+    for (bool busy = true; busy;) {  // Skip layers where a joined run already uses the qubit
+        busy = false;
+        for (int s = 0; s < touched; s++) {
+            const std::vector<int>& used = frontier[comp.qubits[s]].layers;
+            if (joins[s] && std::binary_search(used.begin(), used.end(), layer)) {
+                busy = true;
+                layer++;
             }
         }
-        reg.push_back(comp_column);  // Add vector to register
-    } else {
-        std::vector<component*> comp_column;
-        comp_column.push_back(comp);
-        reg.push_back(comp_column);
     }
+    for (int s = 0; s < touched; s++) {
+        qubit_frontier& f = frontier[comp.qubits[s]];
+        if (joins[s]) {
+            f.layers.insert(std::upper_bound(f.layers.begin(), f.layers.end(), layer), layer);
+            f.last = std::max(f.last, layer);
+        } else {
+            f.axis = axes[s];
+            f.before = f.last;
+            f.last = layer;
+            f.layers.assign(1, layer);
+        }
+    }
+    return static_cast<std::size_t>(layer);
+}
+
+// One past the last gate of a layer
+std::size_t circuit::layer_end(std::size_t layer) const {
+    return layer + 1 < layer_start.size() ? layer_start[layer + 1] : program.size();
 }
 
-// Computes matrix product of current circuit
+// Computes matrix product of current circuit. The single-qubit gates of each layer form one lazy Kronecker
+// operator applied to the running product, so no 2^n x 2^n layer matrix is built and each layer costs
+// O(4^n) per factor instead of a dense O(8^n) multiply; controlled gates are applied as their own operators.
 matrix circuit::get_resultant_matrix() {
-    if (reg.empty()) {
+    profile::scope timer{profile::simulation};
+    require_dense();
+    if (program.empty()) {
         throw std::logic_error("The circuit has no components.");
     }
 
     matrix total_product{matrix_size, matrix_size};
-    for (const auto& comp_column : reg) {
-        matrix column_product = (*comp_column.begin())->get_matrix();
-        auto multiply_matrix = [&](component* comp) {
-            column_product = comp->get_matrix().tensor_product(column_product);
-        };
-
-        std::for_each(comp_column.begin() + 1, comp_column.end(), multiply_matrix);
-        total_product = column_product * total_product;
+    std::vector<matrix> factors(qubits);
+    const std::uint64_t size = static_cast<std::uint64_t>(matrix_size);
+    for (std::size_t layer = 0; layer < layer_start.size(); layer++) {
+        std::size_t moving = 0;
+        {
+            profile::scope building{profile::gate_construction};
+            std::fill(factors.begin(), factors.end(), get_gate_matrix(identity_matrix_id));
+            for (std::size_t g = layer_start[layer]; g < layer_end(layer); g++) {
+                if (!get_gate_info(program[g].op).controlled) {
+                    factors[program[g].qubits[0]] = component_matrix(program[g]);
+                    moving++;
+                }
+            }
+        }
+        if (moving > 0) {
+            kron_operator{factors}.apply_in_place(total_product);
+            profile::count_work(1, 2 * moving * sizeof(std::complex<double>) * size * size, 14 * moving * size * size);
+        }
+        for (std::size_t g = layer_start[layer]; g < layer_end(layer); g++) {
+            if (get_gate_info(program[g].op).controlled) {
+                controlled_operator(program[g], qubits).apply_in_place(total_product);
+                profile::count_work(1, 4 * sizeof(std::complex<double>) * size * size, 28 * size * size);
+            }
+        }
     }
     return total_product;
 }
 
-// Reorder circuit register to minimize number of columns
-void circuit::order_reg() {
-    if (reg.size() == 1) {
-        return;
+// Appends the gates of layers [first, last) in order
+void circuit::append_layers(std::size_t first, std::size_t last, gate_list &gates) const {
+    const std::size_t begin = first < layer_start.size() ? layer_start[first] : program.size();
+    const std::size_t end = last < layer_start.size() ? layer_start[last] : program.size();
+    for (std::size_t g = begin; g < end; g++) {
+        gates.gates.push_back(to_gate_op(program[g], gates));
     }
-    bool moved{false};
-    int i = reg.size() - 1;
-    for (int j = 0; j < reg[i].size(); j++) {
-        if (dynamic_cast<single_component*>(reg[i][j])) {
-            if (reg[i][j]->get_symbol() != "I") {
-                bool leftmost{false};
-                while (!leftmost && i > 0) {
-                    if (reg[i - 1].size() > 1) {
-                        if (reg[i - 1][j]->get_symbol() != "I") {
-                            leftmost = true;
-                        } else {
-                            std::swap(reg[i][j], reg[i - 1][j]);
-                            i--;
-                            moved = true;
-                        }
-                    } else {
-                        leftmost = true;
-                    }
-                }
+}
+
+// Gate list layer by layer
+gate_list circuit::get_gate_list() {
+    gate_list gates;
+    append_layers(0, layer_start.size(), gates);
+    return gates;
+}
+
+// Advances the cached state over the layers added since the last call, O(2^n) per new gate
+matrix circuit::get_current_state() {
+    profile::scope timer{profile::simulation};
+    require_dense();
+    gate_list gates;
+    append_layers(cached_layers, layer_start.size(), gates);
+    cached_layers = layer_start.size();
+    apply_gates(cached_state, gates.gates);
+    return cached_state.to_matrix();
+}
+
+// Arithmetic of one gate over size amplitudes, for the profiler
+static std::uint64_t gate_flops(const gate_op &op, std::size_t size) {
+    const std::uint64_t touched = op.kind == gate_op::controlled ? size / 2 : size;
+    if (op.kind == gate_op::dense) {
+        return 8 * op.m->get_rows() * touched;
+    }
+    if (op.structure == gate_structure::permutation) {
+        return 0;
+    }
+    if (op.structure != gate_structure::dense) {
+        return 6 * touched;  // One complex multiply per amplitude
+    }
+    return 14 * touched;  // Two complex multiplies and an add per amplitude
+}
+
+// Profiler estimate for one gate over size amplitudes; diagonal gates only count their arithmetic,
+// the batched sweep that applies them is counted once
+static void count_gate(const gate_op &op, std::size_t size) {
+    const std::uint64_t touched = op.kind == gate_op::controlled ? size / 2 : size;
+    const std::uint64_t bytes = op.structure == gate_structure::diagonal ? 0 : 2 * sizeof(std::complex<double>) * touched;
+    profile::count_work(1, bytes, gate_flops(op, size));
+}
+
+// Applies each gate to a statevector in place, batching consecutive diagonal gates into one sweep.
+// Work is only counted when asked, as the profiler counters belong to the driving thread.
+template <typename State>
+void circuit::apply_gates(State &state, const std::vector<gate_op> &gates, bool counting) {
+    std::vector<diagonal_factor> diagonal_run;
+    counting = counting && profile::enabled();
+    for (const gate_op& op : gates) {
+        if (counting) {
+            count_gate(op, state.get_size());
+        }
+        if (op.structure == gate_structure::diagonal) {
+            append_diagonal_factors(op, diagonal_run);
+            continue;
+        }
+        if (!diagonal_run.empty()) {
+            state.apply_diagonal(diagonal_run);
+            if (counting) {
+                profile::count_work(0, 2 * sizeof(std::complex<double>) * state.get_size(), 0);
             }
+            diagonal_run.clear();
+        }
+        switch (op.kind) {
+            case gate_op::single:
+                state.apply_single(op.qubits[0], *op.m, op.structure);
+                break;
+            case gate_op::controlled:
+                state.apply_controlled(op.qubits[0], op.qubits[1], *op.m, op.structure);
+                break;
+            case gate_op::dense:
+                state.apply_dense(op.qubits, *op.m);
+                break;
         }
     }
-    if (moved) {
-        reg.pop_back();
+    if (counting && !diagonal_run.empty()) {
+        profile::count_work(0, 2 * sizeof(std::complex<double>) * state.get_size(), 0);
     }
+    state.apply_diagonal(diagonal_run);
 }
 
-// Print statevector in bra-ket notation
-void circuit::print_braket(matrix statevector) {
-    if (statevector.get_cols() != 1 || statevector.get_rows() != matrix_size) { // Checks if input statevector is valid
-        throw std::invalid_argument("Invalid statevector size.");
+// Applies the circuit one layer at a time; each layer is a single cache-blocked pass over the statevector
+// (or a few, when it mixes more qubits than fit in a tile)
+template <typename State>
+void circuit::apply_layers(State &state) {
+    gate_list layer_gates;
+    for (std::size_t layer = 0; layer < layer_start.size(); layer++) {
+        layer_gates.clear();
+        append_layers(layer, layer + 1, layer_gates);
+        if (profile::enabled()) {
+            std::uint64_t flops = 0;
+            for (const gate_op& op : layer_gates.gates) {
+                flops += gate_flops(op, state.get_size());
+            }
+            profile::count_work(layer_gates.gates.size(), 2 * sizeof(std::complex<double>) * state.get_size(), flops);
+        }
+        state.apply_layer(layer_gates.gates);
     }
-    bool first_term = true;
-    for (int i = 1; i <= statevector.get_rows(); i++) {
-        std::complex<double> value = statevector.get_value(i,1);
-        if (std::abs(value) != 0) { // Check if vector element is 0
-            if (!first_term) {
-                if (value.real() > 0 || (value.real() == 0 && value.imag() > 0))
-                std::cout << "+ ";
-            } else {
-                first_term = false;
-            }
-            if (std::abs(value) == 1 && value.imag() == 0) { // Clean up output when real part is +/- 1
-                if (value.real() == 1) {
-                    std::cout << "|";
-                } else {
-                    std::cout << "-|";
-                }
-            } else if (std::abs(value) == 1 && value.real() == 0) { // Clean up output when real part is +/- 1
-                if (value.imag() == 1) {
-                    std::cout << "i|";
-                } else {
-                    std::cout << "-i|";
-                }
-            } else {
-                if(value.real() != 0 && value.imag() == 0) {
-                    std::cout << std::setprecision(3) << value.real() << "|"; 
-                } else if(value.real() == 0 && value.imag() != 0) {
-                    std::cout << std::setprecision(3) << value.imag() << "i|"; 
+}
+
+// Flattens the register and applies the fusion pass selected in the options. The result is kept, so
+// running an unchanged circuit again lowers and fuses nothing.
+const std::vector<gate_op>& circuit::prepare_gates(const sim_options &options) {
+    profile::scope timer{profile::gate_construction};
+    if (program.empty()) {
+        throw std::logic_error("The circuit has no components.");
+    }
+    const int fuse = options.fuse > 0 ? std::min(options.fuse, qubits) : 0;
+    if (prepared_fuse != fuse) {
+        prepared = get_gate_list();
+        if (fuse > 0) {
+            prepared = fuse_gates(std::move(prepared), fuse);
+        }
+        prepared_fuse = fuse;
+    }
+    return prepared.gates;
+}
+
+// Interleaved run that resumes from and writes binary checkpoints. Checkpoint positions count gates of the
+// unfused gate list and each segment between checkpoints is fused on its own, so a resumed run applies
+// exactly the remaining gates whatever --fuse the earlier run used.
+template <typename T>
+matrix circuit::simulate_checkpointed(const sim_options &options) {
+    gate_list lowered;
+    {
+        profile::scope timer{profile::gate_construction};
+        if (program.empty()) {
+            throw std::logic_error("The circuit has no components.");
+        }
+        lowered = get_gate_list();
+    }
+    const std::vector<gate_op>& gates = lowered.gates;
+    basic_statevector<T> state{input_vector};
+    std::size_t next = 0;
+    if (!options.resume_path.empty()) {
+        profile::scope timer{profile::input};
+        checkpoint_file saved{options.resume_path};
+        if (saved.get_qubits() != qubits) {
+            throw std::invalid_argument("Checkpoint has " + std::to_string(saved.get_qubits()) + " qubits but the circuit has "
+                                        + std::to_string(qubits) + ".");
+        }
+        if (saved.get_gate_index() > gates.size()) {
+            throw std::invalid_argument("Checkpoint is past the end of the circuit.");
+        }
+        saved.copy_to(state.data());
+        next = saved.get_gate_index();
+    }
+    const std::size_t step = options.checkpoint_every > 0 ? options.checkpoint_every : gates.size();
+    do {
+        const std::size_t end = std::min(gates.size(), next + step);
+        gate_list segment;
+        segment.gates.assign(gates.begin() + next, gates.begin() + end);
+        if (options.fuse > 0 && !segment.gates.empty()) {
+            profile::scope timer{profile::gate_construction};
+            segment = fuse_gates(std::move(segment), std::min(options.fuse, qubits));
+        }
+        apply_gates(state, segment.gates);
+        next = end;
+        if (!options.checkpoint_path.empty()) {
+            profile::scope timer{profile::output};
+            write_checkpoint(options.checkpoint_path, state.data(), qubits, next);
+        }
+    } while (next < gates.size());
+    return state.to_matrix();
+}
+
+// Computes output statevector by applying each gate to the input vector in place
+matrix circuit::simulate(const sim_options &options) {
+    profile::scope timer{profile::simulation};
+    require_dense();
+    if (!options.checkpoint_path.empty() || !options.resume_path.empty()) {
+        if (options.single_precision) {
+            return simulate_checkpointed<float>(options);
+        }
+        return simulate_checkpointed<double>(options);
+    }
+    if (options.layered) {  // Layers are applied as scheduled, without fusion
+        if (program.empty()) {
+            throw std::logic_error("The circuit has no components.");
+        }
+        if (options.single_precision) {
+            statevector_single state{input_vector};
+            apply_layers(state);
+            return state.to_matrix();
+        }
+        statevector state{input_vector};
+        apply_layers(state);
+        return state.to_matrix();
+    }
+    const std::vector<gate_op>& gates = prepare_gates(options);
+    if (options.split_layout) {
+        split_statevector state{input_vector};
+        apply_gates(state, gates);
+        return state.to_matrix();
+    }
+    if (options.single_precision) {
+        statevector_single state{input_vector};
+        apply_gates(state, gates);
+        return state.to_matrix();
+    }
+    statevector state{input_vector};
+    apply_gates(state, gates);
+    return state.to_matrix();
+}
+
+// Propagates several input vectors through the circuit together as one (2^n x B) block
+std::vector<matrix> circuit::simulate_batch(const std::vector<matrix> &inputs, const sim_options &options) {
+    profile::scope timer{profile::simulation};
+    const std::vector<gate_op>& gates = prepare_gates(options);
+    batch_statevector state{inputs};
+    apply_gates(state, gates);
+    return state.to_matrices();
+}
+
+bool circuit::is_clifford() {
+    for (const component& comp : program) {
+        if (!get_gate_info(comp.op).clifford) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs the circuit on a stabilizer tableau in register order
+stabilizer_tableau circuit::simulate_stabilizer() {
+    profile::scope timer{profile::simulation};
+    stabilizer_tableau tableau{initial_states};
+    for (const component& comp : program) {
+        tableau.apply(comp);
+    }
+    return tableau;
+}
+
+// Runs the circuit on a matrix product state (unfused, the MPS splits every two-qubit gate itself)
+mps_state circuit::simulate_mps(const sim_options &options) {
+    profile::scope timer{profile::simulation};
+    mps_state state{initial_states, options.max_bond, options.mps_cutoff};
+    state.apply_gates(get_gate_list().gates);
+    return state;
+}
+
+// Runs the (optionally fused) gate list on the out-of-core statevector
+mmap_statevector circuit::simulate_mmap(const sim_options &options) {
+    profile::scope timer{profile::simulation};
+    const std::vector<gate_op>& gates = prepare_gates(options);
+    mmap_statevector state{initial_states, options.chunk_qubits, options.mmap_dir};
+    state.apply_gates(gates);
+    return state;
+}
+
+// Runs the (optionally fused) gate list on shards owned by worker processes, sharing --threads among them
+sharded_statevector circuit::simulate_sharded(const sim_options &options) {
+    profile::scope timer{profile::simulation};
+    const std::vector<gate_op>& gates = prepare_gates(options);
+    sharded_statevector state{initial_states, options.shards, std::max(1, options.threads / options.shards)};
+    state.apply_gates(gates);
+    return state;
+}
+
+// Compiles the register as it stands for runs at many parameter values
+compiled_circuit circuit::compile(const sim_options &options) {
+    profile::scope timer{profile::gate_construction};
+    require_dense();
+    if (program.empty()) {
+        throw std::logic_error("The circuit has no components.");
+    }
+    return compiled_circuit{qubits, input_vector, program, options.fuse > 0 ? std::min(options.fuse, qubits) : 0};
+}
+
+compiled_circuit::compiled_circuit(int qubits, const matrix &input, const std::vector<component> &program, int fuse)
+    : qubits{qubits}, parameters{0}, input_vector{input} {
+    std::vector<gate_op> gates;
+    for (const component& comp : program) {
+        gates.push_back(to_gate_op(comp, fused));
+        parameters = std::max(parameters, comp.parameter + 1);
+    }
+    std::vector<fused_group> plan;
+    if (fuse > 0) {
+        plan = plan_fusion(gates, fuse);
+    } else {
+        for (std::size_t g = 0; g < gates.size(); g++) {
+            plan.push_back(fused_group{{{g}}});
+        }
+    }
+    // Keep a private copy of the members of every fused gate that contains a parameterised rotation
+    for (const fused_group& group : plan) {
+        fused.gates.push_back(build_fused_gate(group, gates, fused));
+        bound_gate entry{fused.gates.size() - 1, fused_group(), {}, {}};
+        for (const std::vector<std::size_t>& run : group.runs) {
+            std::vector<std::size_t> local;
+            for (std::size_t g : run) {
+                if (program[g].parameter >= 0) {
+                    entry.rotations.emplace_back(entry.members.size(), program[g]);
                 }
+                local.push_back(entry.members.size());
+                entry.members.push_back(gates[g]);
             }
+            entry.group.runs.push_back(local);
+        }
+        if (!entry.rotations.empty()) {
+            bound.push_back(std::move(entry));
+        }
+    }
+}
 
-            // Calculates string inside ket using bitset
-            for (int j = qubits - 1; j >= 0; j--) {
-                std::cout << (((i-1) >> j) & 1);
+// Accessors
+int compiled_circuit::get_parameter_count() const {
+    return parameters;
+}
+
+std::size_t compiled_circuit::get_gate_count() const {
+    return fused.gates.size();
+}
+
+std::size_t compiled_circuit::get_bound_count() const {
+    return bound.size();
+}
+
+// Throws unless a parameter point supplies a value for every parameter the circuit uses
+static void check_point(const std::vector<double> &values, int parameters) {
+    if (static_cast<int>(values.size()) < parameters) {
+        throw std::invalid_argument("Parameter point has " + std::to_string(values.size()) + " values but the circuit uses "
+                                    + std::to_string(parameters) + ".");
+    }
+}
+
+gate_list compiled_circuit::bind(const std::vector<double> &values) const {
+    check_point(values, parameters);
+    gate_list gates;
+    gates.gates = fused.gates;
+    std::vector<gate_op> members;
+    for (const bound_gate& entry : bound) {
+        members = entry.members;
+        for (const std::pair<std::size_t, component>& rotation : entry.rotations) {
+            const component& comp = rotation.second;
+            members[rotation.first].m = gates.keep(rotation_matrix(comp.op, values[comp.parameter]));
+        }
+        gates.gates[entry.position] = build_fused_gate(entry.group, members, gates);
+    }
+    return gates;
+}
+
+matrix compiled_circuit::run_point(const std::vector<double> &values, bool counting) const {
+    statevector state{input_vector};
+    circuit::apply_gates(state, bind(values).gates, counting);
+    return state.to_matrix();
+}
+
+matrix compiled_circuit::run(const std::vector<double> &values) const {
+    profile::scope timer{profile::simulation};
+    return run_point(values, true);
+}
+
+std::vector<matrix> compiled_circuit::sweep(const std::vector<std::vector<double>> &points) const {
+    profile::scope timer{profile::simulation};
+    for (const std::vector<double>& values : points) {  // Checked up front: worker threads must not throw
+        check_point(values, parameters);
+    }
+    std::vector<matrix> outputs(points.size());
+    thread_pool* pool = thread_pool::shared();
+    if (pool == nullptr || points.size() < static_cast<std::size_t>(pool->get_threads())) {
+        for (std::size_t p = 0; p < points.size(); p++) {
+            outputs[p] = run_point(points[p], true);
+        }
+        return outputs;
+    }
+    // One point per task; the gate sweeps inside each run stay on its thread
+    pool->parallel_for(points.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t p = begin; p < end; p++) {
+            outputs[p] = run_point(points[p], false);
+        }
+    });
+    if (profile::enabled()) {
+        const std::size_t size = std::size_t{1} << qubits;
+        for (std::size_t p = 0; p < points.size(); p++) {
+            for (const gate_op& op : fused.gates) {
+                count_gate(op, size);
             }
-        std::cout << "> ";
-        }   
+        }
     }
+    return outputs;
 }
 
+// Print statevector in bra-ket notation
+void circuit::print_braket(const matrix &statevector, const braket_format &format) {
+    ::print_braket(statevector, qubits, format);
+}
+
+// Gate symbol centred in the three columns inside a gate box ("X" -> " X ", "Rx" -> "Rx ")
+static std::string box_label(const char* symbol) {
+    const std::string label = symbol;
+    return label.size() == 1 ? " " + label + " " : label + " ";
+}
+
+// What one drawing column shows on one qubit line
+struct diagram_cell
+{
+    enum cell_kind { idle, gate, control, target, wire };
+    cell_kind kind;
+    std::string label;  // Gate and target cells
+    bool link_up;       // Control and target cells: the other end of the gate is on a line above
+};
+
 // Print ASCII representation of the circuit
 void circuit::draw() {
-    // Determine which columns of the circuit register contain multi-qubit components
-    std::vector<std::vector<int>> multi_gates; // Stores control and target locations of multi-qubit gates 
-    std::vector<std::string> multi_gate_symbols;
-    for (int j=0; j<reg.size(); j++) { 
-        if (dynamic_cast<multi_component*>(reg[j][0])) {
-                multi_component* gate = dynamic_cast<multi_component*>(reg[j][0]);
-                int control = gate->get_control();
-                int target = gate->get_target();
-
-                std::vector<int> control_target_locations;
-                control_target_locations.push_back(control);
-                control_target_locations.push_back(target);
-                multi_gates.push_back(control_target_locations);
-                multi_gate_symbols.push_back(gate->get_symbol());
-        } else {
-            std::vector<int> empty_vector;
-            multi_gates.push_back(empty_vector);
-            multi_gate_symbols.push_back("0");
+    profile::scope timer{profile::output};
+    // Each layer is drawn as few columns as possible: gates share a column when the spans of their
+    // vertical control lines do not overlap
+    std::vector<std::vector<diagram_cell>> columns;
+    for (std::size_t layer = 0; layer < layer_start.size(); layer++) {
+        const std::size_t first_column = columns.size();
+        std::vector<std::vector<bool>> taken;  // Lines used by each column of this layer
+        for (std::size_t g = layer_start[layer]; g < layer_end(layer); g++) {
+            const component& comp = program[g];
+            const gate_info& info = get_gate_info(comp.op);
+            const int control = comp.qubits[0];
+            const int target = info.controlled ? comp.qubits[1] : comp.qubits[0];
+            const int lo = std::min(control, target);
+            const int hi = std::max(control, target);
+            auto clashes = [&](const std::vector<bool> &lines) {
+                return std::find(lines.begin() + lo, lines.begin() + hi + 1, true) != lines.begin() + hi + 1;
+            };
+            std::size_t j = 0;
+            while (j < taken.size() && clashes(taken[j])) {
+                j++;
+            }
+            if (j == taken.size()) {
+                taken.emplace_back(qubits, false);
+                columns.emplace_back(qubits, diagram_cell{diagram_cell::idle, "", false});
+            }
+            std::fill(taken[j].begin() + lo, taken[j].begin() + hi + 1, true);
+            std::vector<diagram_cell>& column = columns[first_column + j];
+            if (!info.controlled) {
+                column[target] = diagram_cell{diagram_cell::gate, box_label(info.symbol), false};
+                continue;
+            }
+            for (int i = lo + 1; i < hi; i++) {
+                column[i] = diagram_cell{diagram_cell::wire, "", false};
+            }
+            column[control] = diagram_cell{diagram_cell::control, "", target < control};
+            column[target] = diagram_cell{diagram_cell::target, box_label(info.symbol), control < target};
         }
     }
 
@@ -158,90 +613,139 @@ void circuit::draw() {
     for (int i=0; i<qubits; i++) {
         // Top third of line
         std::cout << "        ";
-        for (int j=0; j<reg.size(); j++) { // Loop over columns in register
-            if (!multi_gates[j].empty()) {   
-                if (multi_gates[j][0] > multi_gates[j][1]) {
-                    if (multi_gates[j][0] == i) {
-                        std::cout << "    │    ";
-                    } else if (multi_gates[j][1] == i) {
-                        std::cout << "  ┌───┐  ";
-                    } else if ((multi_gates[j][0] < i && i < multi_gates[j][1]) || (multi_gates[j][0] > i && i > multi_gates[j][1])) {
-                        std::cout << "    │    ";
-                    } else {
-                        std::cout << "         ";
-                    }
-                } else {
-                    if(multi_gates[j][0] == i) {
-                        std::cout << "         ";
-                    } else if (multi_gates[j][1] == i) {
-                        std::cout << "  ┌─┴─┐  ";
-                    } else if ((multi_gates[j][0] < i && i < multi_gates[j][1]) || (multi_gates[j][0] > i && i > multi_gates[j][1])) {
-                        std::cout << "    │    ";
-                    } else {
-                        std::cout << "         ";
-                    }
-                }
-            } else if (reg[j][i]->get_symbol() == "I") {
-                std::cout << "         ";
-            } else {
-                std::cout << "  ┌───┐  ";
+        for (const std::vector<diagram_cell>& column : columns) {
+            const diagram_cell& c = column[i];
+            switch (c.kind) {
+                case diagram_cell::gate: std::cout << "  ┌───┐  "; break;
+                case diagram_cell::control: std::cout << (c.link_up ? "    │    " : "         "); break;
+                case diagram_cell::target: std::cout << (c.link_up ? "  ┌─┴─┐  " : "  ┌───┐  "); break;
+                case diagram_cell::wire: std::cout << "    │    "; break;
+                default: std::cout << "         "; break;
             }
         }
         std::cout << std::endl;
 
         // Middle third of line
         std::cout << "q" << i << ": " << "|" << initial_states[i] << "⟩ " ;
-        for (int j=0; j<reg.size(); j++) { // Loop over columns in register
-            if (!multi_gates[j].empty()) {
-                if (multi_gates[j][0] == i) { // Target qubit
-                    std::cout << "────■────";
-                } else if (multi_gates[j][1] == i) { // Control qubit
-                    std::cout << "──┤ " << multi_gate_symbols[j] << " ├──"; // Print component symbol in the square
-                } else if ((multi_gates[j][0] < i && i < multi_gates[j][1]) || (multi_gates[j][0] > i && i > multi_gates[j][1])) {
-                    std::cout << "────┼────";
-                } else {
-                    std::cout << "─────────";
-                }
-            } else if (reg[j][i]->get_symbol() == "I") {
-                std::cout << "─────────";
-            } else {
-                std::cout << "──┤ " + reg[j][i]->get_symbol() + " ├──";
+        for (const std::vector<diagram_cell>& column : columns) {
+            const diagram_cell& c = column[i];
+            switch (c.kind) {
+                case diagram_cell::gate:
+                case diagram_cell::target: std::cout << "──┤" + c.label + "├──"; break;  // Component symbol in the square
+                case diagram_cell::control: std::cout << "────■────"; break;
+                case diagram_cell::wire: std::cout << "────┼────"; break;
+                default: std::cout << "─────────"; break;
             }
         }
         std::cout << std::endl;
 
         // Bottom third of line
         std::cout << "        ";
-        for (int j=0; j<reg.size(); j++) { // Loop over columns in register
-            if (!multi_gates[j].empty()) {   
-                if (multi_gates[j][0] > multi_gates[j][1]) {
-                    if(multi_gates[j][0] == i) { // Target qubit
-                        std::cout << "         ";
-                    } else if (multi_gates[j][1] == i) { // Control qubit
-                        std::cout << "  └─┬─┘  ";
-                    } else if ((multi_gates[j][0] < i && i < multi_gates[j][1]) || (multi_gates[j][0] > i && i > multi_gates[j][1])) {
-                        std::cout << "    │    ";
-                    } else {
-                        std::cout << "         ";
-                    }
-                } else {
-                    if (multi_gates[j][0] == i) {
-                        std::cout << "    │    ";
-                    } else if (multi_gates[j][1] == i) {
-                        std::cout << "  └───┘  ";
-                    } else if ((multi_gates[j][0] < i && i < multi_gates[j][1]) || (multi_gates[j][0] > i && i > multi_gates[j][1])) {
-                        std::cout << "    │    ";
-                    } else {
-                        std::cout << "         ";
-                    }
-                }
-            } else if (reg[j][i]->get_symbol() == "I") {
-                std::cout << "         ";  
-            } else {
-                std::cout << "  └───┘  ";
+        for (const std::vector<diagram_cell>& column : columns) {
+            const diagram_cell& c = column[i];
+            switch (c.kind) {
+                case diagram_cell::gate: std::cout << "  └───┘  "; break;
+                case diagram_cell::control: std::cout << (c.link_up ? "         " : "    │    "); break;
+                case diagram_cell::target: std::cout << (c.link_up ? "  └───┘  " : "  └─┬─┘  "); break;
+                case diagram_cell::wire: std::cout << "    │    "; break;
+                default: std::cout << "         "; break;
             }
         }
         std::cout << std::endl;
     }
     std::cout << std::endl;
 }
+
+// Writes one term of the bra-ket sum for basis state index
+static void write_term(output_writer &out, std::complex<double> value, std::size_t index, int qubits, bool first,
+                       bool probabilities) {
+    if (probabilities) {
+        if (!first) {
+            out.put("+ ");
+        }
+        out.put_number(std::norm(value), 3);
+        out.put('|');
+    } else {
+        const bool complex_term = value.real() != 0 && value.imag() != 0;
+        if (!first && (complex_term || value.real() > 0 || (value.real() == 0 && value.imag() > 0))) {
+            out.put("+ ");
+        }
+        if (std::abs(value) == 1 && value.imag() == 0) { // Clean up output when real part is +/- 1
+            out.put(value.real() == 1 ? "|" : "-|");
+        } else if (std::abs(value) == 1 && value.real() == 0) { // Clean up output when imaginary part is +/- 1
+            out.put(value.imag() == 1 ? "i|" : "-i|");
+        } else if (value.imag() == 0) {
+            out.put_number(value.real(), 3);
+            out.put('|');
+        } else if (value.real() == 0) {
+            out.put_number(value.imag(), 3);
+            out.put("i|");
+        } else {
+            out.put('(');
+            out.put_number(value.real(), 3);
+            if (value.imag() > 0) {
+                out.put('+');
+            }
+            out.put_number(value.imag(), 3);
+            out.put("i)|");
+        }
+    }
+    for (int j = qubits - 1; j >= 0; j--) {
+        out.put(((index >> j) & 1) ? '1' : '0');
+    }
+    out.put("> ");
+}
+
+// Print a statevector of the given register size in bra-ket notation
+void print_braket(const matrix &statevector, int qubits, const braket_format &format) {
+    profile::scope timer{profile::output};
+    if (statevector.get_cols() != 1 || statevector.get_rows() != (1 << qubits)) { // Checks if input statevector is valid
+        throw std::invalid_argument("Invalid statevector size.");
+    }
+    const std::complex<double>* amplitudes = statevector.data();
+    const std::size_t size = statevector.get_rows();
+    const double epsilon = format.epsilon;
+    auto kept = [epsilon](std::complex<double> value) {
+        return epsilon > 0 ? std::abs(value) > epsilon : (value.real() != 0 || value.imag() != 0);
+    };
+    output_writer out{std::cout};
+    if (format.top == 0) {
+        bool first = true;
+        for (std::size_t i = 0; i < size; i++) {
+            if (kept(amplitudes[i])) {
+                write_term(out, amplitudes[i], i, qubits, first, format.probabilities);
+                first = false;
+            }
+        }
+        return;
+    }
+
+    // Top-k: candidates are trimmed back to the k most probable whenever 2k have accumulated, so memory
+    // stays O(k); ties go to the lower index
+    typedef std::pair<double, std::size_t> candidate;  // (probability, index)
+    auto more_probable = [](const candidate &a, const candidate &b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    };
+    const std::size_t k = format.top;
+    std::vector<candidate> best;
+    best.reserve(2 * k);
+    for (std::size_t i = 0; i < size; i++) {
+        if (!kept(amplitudes[i])) {
+            continue;
+        }
+        best.emplace_back(std::norm(amplitudes[i]), i);
+        if (best.size() == 2 * k) {
+            std::nth_element(best.begin(), best.begin() + k, best.end(), more_probable);
+            best.resize(k);
+        }
+    }
+    const std::size_t count = std::min(k, best.size());
+    std::partial_sort(best.begin(), best.begin() + count, best.end(), more_probable);
+    for (std::size_t t = 0; t < count; t++) {
+        write_term(out, amplitudes[best[t].second], best[t].second, qubits, t == 0, format.probabilities);
+    }
+}
+
+const char* braket_label(const braket_format &format) {
+    return format.probabilities ? "P = " : "ψ = ";
+}
@@ -0,0 +1,369 @@
+#include "circuit_file.h"
+#include <stdexcept>
+#include <chrono>
+#include <sstream>
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+#include <cmath>
+#include <algorithm>
+#include "circuit.h"
+#include "input_handler.h"
+#include "stabilizer.h"
+#include "profiler.h"
+
+circuit_reader::circuit_reader(std::istream &in) : in(in) {}
+
+// Reads the next non-empty line into whitespace-separated tokens, dropping comments
+bool circuit_reader::read_tokens() {
+    while (std::getline(in, line)) {
+        line_number++;
+        tokens.clear();
+        std::size_t pos = 0;
+        const std::size_t length = line.size();
+        while (pos < length) {
+            while (pos < length && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r')) {
+                pos++;
+            }
+            if (pos >= length || line[pos] == '#') {
+                break;
+            }
+            std::size_t start = pos;
+            while (pos < length && line[pos] != ' ' && line[pos] != '\t' && line[pos] != '\r' && line[pos] != '#') {
+                pos++;
+            }
+            tokens.emplace_back(line, start, pos - start);
+        }
+        if (!tokens.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parses a non-negative integer token
+static int parse_index(const std::string &token, int line_number) {
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(token.c_str(), &end, 10);
+    if (token.empty() || *end != '\0' || errno != 0 || value < 0 || value > 1000000) {
+        throw std::runtime_error("line " + std::to_string(line_number) + ": expected a non-negative integer, got '" + token + "'");
+    }
+    return static_cast<int>(value);
+}
+
+// Parses a finite real token; returns false when the token is not a number
+static bool parse_real(const std::string &token, double &value) {
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtod(token.c_str(), &end);
+    return !token.empty() && *end == '\0' && errno == 0 && std::isfinite(value);
+}
+
+// Parameter names are identifiers, so they can never be mistaken for an angle
+static bool is_parameter_name(const std::string &token) {
+    if (token.empty() || !(std::isalpha(static_cast<unsigned char>(token[0])) || token[0] == '_')) {
+        return false;
+    }
+    for (char c : token) {
+        if (!(std::isalnum(static_cast<unsigned char>(c)) || c == '_')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool circuit_reader::next(circuit_spec &spec) {
+    if (!header_pending && !read_tokens()) {
+        return false;
+    }
+    header_pending = false;
+
+    spec = circuit_spec();
+    spec.first_line = line_number;
+    std::string error;
+    if (tokens[0] != "qubits" || tokens.size() != 2) {
+        error = "line " + std::to_string(line_number) + ": expected 'qubits N'";
+    } else {
+        try {
+            spec.qubits = parse_index(tokens[1], line_number);
+            if (spec.qubits < 1 || spec.qubits > max_file_qubits) {
+                error = "line " + std::to_string(line_number) + ": qubit count must be between 1 and " + std::to_string(max_file_qubits);
+            }
+        } catch (const std::runtime_error& e) {
+            error = e.what();
+        }
+    }
+    spec.initial_states.assign(spec.qubits, '0');
+
+    // Consume the rest of the circuit even after an error so the next call starts cleanly
+    while (read_tokens()) {
+        if (tokens[0] == "qubits") {
+            header_pending = true;
+            break;
+        }
+        if (tokens[0] == "end") {
+            break;
+        }
+        if (!error.empty()) {
+            continue;
+        }
+        try {
+            if (tokens[0] == "init") {
+                if (tokens.size() != 2 || static_cast<int>(tokens[1].size()) != spec.qubits
+                    || tokens[1].find_first_not_of("01") != std::string::npos) {
+                    throw std::runtime_error("line " + std::to_string(line_number) + ": 'init' needs one 0/1 per qubit");
+                }
+                for (int q = 0; q < spec.qubits; q++) {
+                    spec.initial_states[q] = tokens[1][spec.qubits - 1 - q];  // Ket order: qubit n-1 first
+                }
+            } else if (tokens[0] == "param") {
+                double value = 0;
+                if (tokens.size() < 2 || tokens.size() > 3 || !is_parameter_name(tokens[1])
+                    || (tokens.size() == 3 && !parse_real(tokens[2], value))) {
+                    throw std::runtime_error("line " + std::to_string(line_number) + ": expected 'param NAME [VALUE]'");
+                }
+                if (std::find(spec.parameter_names.begin(), spec.parameter_names.end(), tokens[1]) != spec.parameter_names.end()) {
+                    throw std::runtime_error("line " + std::to_string(line_number) + ": parameter '" + tokens[1] + "' declared twice");
+                }
+                spec.parameter_names.push_back(tokens[1]);
+                spec.parameter_defaults.push_back(value);
+            } else {
+                gate_spec gate;
+                gate.name = tokens[0];
+                gate.line = line_number;
+                std::size_t end = tokens.size();
+                const gate_info* info = find_gate_info(gate.name);
+                if (info != nullptr && info->parameterized && end > 1) {  // The angle comes last
+                    const std::string& angle = tokens[--end];
+                    if (!parse_real(angle, gate.angle)) {
+                        const std::vector<std::string>& names = spec.parameter_names;
+                        const std::size_t p = std::find(names.begin(), names.end(), angle) - names.begin();
+                        if (p == names.size()) {
+                            throw std::runtime_error("line " + std::to_string(line_number) + ": '" + angle
+                                                     + "' is neither an angle nor a declared parameter");
+                        }
+                        gate.parameter = static_cast<int>(p);
+                        gate.angle = spec.parameter_defaults[p];
+                    }
+                }
+                for (std::size_t t = 1; t < end; t++) {
+                    gate.qubits.push_back(parse_index(tokens[t], line_number));
+                }
+                spec.gates.push_back(gate);
+            }
+        } catch (const std::runtime_error& e) {
+            error = e.what();
+        }
+    }
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+    if (spec.gates.empty()) {
+        throw std::runtime_error("line " + std::to_string(spec.first_line) + ": circuit has no gates");
+    }
+    return true;
+}
+
+// Circuit class for a statevector run, with the register ordered as the interactive mode does
+static circuit build_circuit(const circuit_spec &spec, const std::vector<component> &components, const sim_options &options) {
+    if (spec.qubits > max_statevector_qubits) {
+        throw std::runtime_error("line " + std::to_string(spec.first_line) + ": " + std::to_string(spec.qubits)
+                                 + " qubits is too many for the statevector backend (max "
+                                 + std::to_string(max_statevector_qubits) + ")");
+    }
+    matrix input_vector = options.initial_state_path.empty() ? get_input_vector(spec.initial_states)
+                                                             : load_input_vector(options.initial_state_path, spec.qubits);
+    circuit c{spec.qubits, input_vector, spec.initial_states};
+    for (const component& comp : components) {
+        c.add(comp);
+    }
+    return c;
+}
+
+// Statevector run through the circuit class, printing the output amplitudes
+static void run_statevector(const circuit_spec &spec, const std::vector<component> &components, int index,
+                            const sim_options &options) {
+    circuit c = build_circuit(spec, components, options);
+    matrix output_vector = c.simulate(options);
+    std::cout << "circuit " << index << ": " << braket_label(options.output);
+    c.print_braket(output_vector, options.output);
+    std::cout << "\n";
+    if (options.shots > 0) {
+        display_measurements(output_vector, options);
+    }
+}
+
+// Parameter sweep: the circuit is compiled once and each point only rebinds its rotation angles. Points
+// run in groups of --threads, one per thread, so only that many output states are held at a time.
+static void run_sweep(const circuit_spec &spec, const std::vector<component> &components, int index,
+                      const sim_options &options, const std::vector<parameter_point> &points) {
+    std::vector<std::vector<double>> values;  // Each point in the circuit's parameter order
+    const std::vector<std::string>& names = spec.parameter_names;
+    for (const parameter_point& point : points) {
+        std::vector<double> bound = spec.parameter_defaults;
+        for (const std::pair<std::string, double>& value : point.values) {
+            const std::size_t p = std::find(names.begin(), names.end(), value.first) - names.begin();
+            if (p == names.size()) {
+                throw std::runtime_error("sweep line " + std::to_string(point.line) + ": circuit has no parameter '"
+                                         + value.first + "'");
+            }
+            bound[p] = value.second;
+        }
+        values.push_back(bound);
+    }
+    circuit c = build_circuit(spec, components, options);
+    const compiled_circuit compiled = c.compile(options);
+    const std::size_t group = options.threads;
+    for (std::size_t first = 0; first < values.size(); first += group) {
+        const std::size_t last = std::min(values.size(), first + group);
+        std::vector<matrix> outputs = compiled.sweep(std::vector<std::vector<double>>(values.begin() + first, values.begin() + last));
+        for (std::size_t p = first; p < last; p++) {
+            std::cout << "circuit " << index << " point " << p + 1 << ": " << braket_label(options.output);
+            c.print_braket(outputs[p - first], options.output);
+            std::cout << "\n";
+            if (options.shots > 0) {
+                display_measurements(outputs[p - first], options);
+            }
+        }
+    }
+}
+
+// Circuit class for the backends that keep their own state, holding only the initial basis states
+static circuit build_backend_circuit(const circuit_spec &spec, const std::vector<component> &components) {
+    circuit c{spec.qubits, spec.initial_states};
+    for (const component& comp : components) {
+        c.add(comp);
+    }
+    return c;
+}
+
+// Tableau run for Clifford-only circuits, printing the stabilizer generators
+static void run_stabilizer(circuit &c, int index, const sim_options &options) {
+    stabilizer_tableau tableau = c.simulate_stabilizer();
+    std::cout << "circuit " << index << ": stabilizers =";
+    for (const std::string& generator : tableau.get_stabilizers()) {
+        std::cout << " " << generator;
+    }
+    std::cout << "\n";
+    if (options.shots > 0) {
+        display_measurements(tableau, options);
+    }
+}
+
+// Builds and simulates one circuit on the backend chosen for it, printing its output state
+static void run_circuit(const circuit_spec &spec, int index, const sim_options &options,
+                        const std::vector<parameter_point> &points) {
+    profile::scope timer{profile::output};  // Printing; construction and simulation carve out their own time
+    std::vector<component> components;
+    components.reserve(spec.gates.size());
+    bool clifford = true;
+    for (const gate_spec& gate : spec.gates) {
+        try {
+            const gate_info* info = find_gate_info(gate.name);
+            if (info != nullptr && info->parameterized) {
+                components.push_back(make_rotation(gate.name, gate.qubits, spec.qubits, gate.angle, gate.parameter));
+            } else {
+                components.push_back(make_component(gate.name, gate.qubits, spec.qubits));
+            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error("line " + std::to_string(gate.line) + ": " + e.what());
+        }
+        clifford = clifford && get_gate_info(components.back().op).clifford;
+    }
+    if (!points.empty() && !spec.parameter_names.empty()) {  // Circuits without parameters run once
+        run_sweep(spec, components, index, options, points);
+        return;
+    }
+    const backend_kind backend = resolve_backend(options, spec.qubits, clifford);
+    if (backend == backend_kind::statevector) {
+        run_statevector(spec, components, index, options);
+        return;
+    }
+    // Each state is complete before its line starts, so an error leaves no partial output
+    circuit c = build_backend_circuit(spec, components);
+    switch (backend) {
+        case backend_kind::stabilizer:
+            run_stabilizer(c, index, options);
+            break;
+        case backend_kind::mps: {
+            mps_state state = c.simulate_mps(options);
+            std::cout << "circuit " << index << ": ";
+            display_backend_output(state, options);
+            break;
+        }
+        case backend_kind::mmap: {
+            mmap_statevector state = c.simulate_mmap(options);
+            std::cout << "circuit " << index << ": ";
+            display_backend_output(state, options);
+            break;
+        }
+        default: {
+            sharded_statevector state = c.simulate_sharded(options);
+            std::cout << "circuit " << index << ": ";
+            display_backend_output(state, options);
+            break;
+        }
+    }
+}
+
+std::vector<parameter_point> read_sweep_points(std::istream &in) {
+    std::vector<parameter_point> points;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        std::istringstream fields{line.substr(0, line.find('#'))};
+        parameter_point point;
+        point.line = line_number;
+        std::string field;
+        while (fields >> field) {
+            const std::size_t equals = field.find('=');
+            double value = 0;
+            if (equals == std::string::npos || !is_parameter_name(field.substr(0, equals))
+                || !parse_real(field.substr(equals + 1), value)) {
+                throw std::runtime_error("sweep line " + std::to_string(line_number) + ": expected 'name=value', got '" + field + "'");
+            }
+            point.values.emplace_back(field.substr(0, equals), value);
+        }
+        if (!point.values.empty()) {
+            points.push_back(point);
+        }
+    }
+    return points;
+}
+
+int run_batch(std::istream &in, const sim_options &options, const std::vector<parameter_point> &points) {
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    circuit_reader reader{in};
+    circuit_spec spec;
+    int index = 0;
+    int failures = 0;
+    while (true) {
+        try {
+            if (!reader.next(spec)) {
+                break;
+            }
+        } catch (const std::exception& e) {
+            std::cout << "circuit " << ++index << ": error: " << e.what() << "\n";
+            failures++;
+            continue;
+        }
+        try {
+            run_circuit(spec, ++index, options, points);
+        } catch (const std::exception& e) {
+            std::cout << "circuit " << index << ": error: " << e.what() << "\n";
+            failures++;
+        }
+    }
+    std::cout.flush();
+
+    double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    std::cerr << "Ran " << index << " circuits (" << failures << " failed) in " << elapsed << " s";
+    if (elapsed > 0) {
+        std::cerr << " (" << index / elapsed << " circuits/s)";
+    }
+    std::cerr << std::endl;
+    return failures;
+}
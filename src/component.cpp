@@ -1,129 +1,166 @@
 #include "component.h"
-
-component::component(matrix mat, std::string sym) : m{mat}, symbol{sym} {}
-
-matrix component::get_matrix() {
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include "profiler.h"
+
+// Builds a 2x2 matrix from its entries (row-major)
+static matrix make_2x2(std::complex<double> a, std::complex<double> b, std::complex<double> c, std::complex<double> d) {
+    matrix m{2, 2};
+    m.set_value(1, 1, a);
+    m.set_value(1, 2, b);
+    m.set_value(2, 1, c);
+    m.set_value(2, 2, d);
     return m;
 }
 
-std::string component::get_symbol() {
-    return symbol;
-}
-
-// Single-qubit component constructor
-single_component::single_component(matrix mat, std::string sym, int q) : component{mat, sym}, qubit{q} {}
-
-int single_component::get_qubit() {
-    return qubit;
-}
-
-pauli_x::pauli_x(int q) : single_component{matrix{2, 2}, "X", q} {
-    m.set_value(1, 1, std::complex<double>{0, 0});
-    m.set_value(1, 2, std::complex<double>{1, 0});
-    m.set_value(2, 1, std::complex<double>{1, 0});
-    m.set_value(2, 2, std::complex<double>{0, 0});
-}
-
-pauli_y::pauli_y(int q) : single_component{matrix{2, 2}, "Y", q} {
-    m.set_value(1, 1, std::complex<double>{0, 0});
-    m.set_value(1, 2, std::complex<double>{0, -1});
-    m.set_value(2, 1, std::complex<double>{0, 1});
-    m.set_value(2, 2, std::complex<double>{0, 0});
-}
-
-pauli_z::pauli_z(int q) : single_component{matrix{2, 2}, "Z", q} {
-    m.set_value(1, 1, std::complex<double>{1, 0});
-    m.set_value(1, 2, std::complex<double>{0, 0});
-    m.set_value(2, 1, std::complex<double>{0, 0});
-    m.set_value(2, 2, std::complex<double>{-1, 0});
-}
-
-hadamard::hadamard(int q) : single_component{matrix{2, 2}, "H", q} {
-    m.set_value(1, 1, std::complex<double>{1 / sqrt(2), 0});
-    m.set_value(1, 2, std::complex<double>{1 / sqrt(2), 0});
-    m.set_value(2, 1, std::complex<double>{1 / sqrt(2), 0});
-    m.set_value(2, 2, std::complex<double>{-1 / sqrt(2), 0});
-}
-
-identity::identity(int size) : single_component{matrix{size, size}, "I", 0} {
-    for (int i = 0; i < size; ++i) {
-        m.set_value(i + 1, i + 1, std::complex<double>{1, 0});
+// Shared table of gate matrices, built once; ids match gate_info::matrix_id and the constants in component.h
+static const std::vector<matrix>& gate_matrices() {
+    static const std::vector<matrix> table = [] {
+        const double r = 1 / std::sqrt(2.0);
+        std::vector<matrix> t;
+        t.push_back(make_2x2(0, 1, 1, 0));                                                      // X
+        t.push_back(make_2x2(0, std::complex<double>{0, -1}, std::complex<double>{0, 1}, 0));  // Y
+        t.push_back(make_2x2(1, 0, 0, -1));                                                     // Z
+        t.push_back(make_2x2(r, r, r, -r));                                                     // H
+        t.push_back(make_2x2(1, 0, 0, 1));                                                      // I
+        t.push_back(make_2x2(1, 0, 0, 0));                                                      // |0><0|
+        t.push_back(make_2x2(0, 0, 0, 1));                                                      // |1><1|
+        return t;
+    }();
+    return table;
+}
+
+static const gate_info gate_table[] = {
+    {"x", "X", false, true, false, 0, gate_structure::permutation, gate_axis::x},
+    {"y", "Y", false, true, false, 1, gate_structure::phase_permutation, gate_axis::y},
+    {"z", "Z", false, true, false, 2, gate_structure::diagonal, gate_axis::z},
+    {"h", "H", false, true, false, 3, gate_structure::dense, gate_axis::none},
+    {"cx", "X", true, true, false, 0, gate_structure::permutation, gate_axis::x},
+    {"cy", "Y", true, true, false, 1, gate_structure::phase_permutation, gate_axis::y},
+    {"cz", "Z", true, true, false, 2, gate_structure::diagonal, gate_axis::z},
+    {"ch", "H", true, false, false, 3, gate_structure::dense, gate_axis::none},
+    {"rx", "Rx", false, false, true, identity_matrix_id, gate_structure::dense, gate_axis::x},
+    {"ry", "Ry", false, false, true, identity_matrix_id, gate_structure::dense, gate_axis::y},
+    {"rz", "Rz", false, false, true, identity_matrix_id, gate_structure::diagonal, gate_axis::z},
+    {"phase", "P", false, false, true, identity_matrix_id, gate_structure::diagonal, gate_axis::z},
+    {"crx", "Rx", true, false, true, identity_matrix_id, gate_structure::dense, gate_axis::x},
+    {"cry", "Ry", true, false, true, identity_matrix_id, gate_structure::dense, gate_axis::y},
+    {"crz", "Rz", true, false, true, identity_matrix_id, gate_structure::diagonal, gate_axis::z},
+    {"cphase", "P", true, false, true, identity_matrix_id, gate_structure::diagonal, gate_axis::z},
+};
+
+static const int gate_count = sizeof(gate_table) / sizeof(gate_table[0]);
+
+const gate_info& get_gate_info(gate_opcode op) {
+    return gate_table[static_cast<int>(op)];
+}
+
+const matrix& get_gate_matrix(std::uint16_t matrix_id) {
+    return gate_matrices().at(matrix_id);
+}
+
+const gate_info* find_gate_info(const std::string &name) {
+    for (int op = 0; op < gate_count; op++) {
+        if (name == gate_table[op].name) {
+            return &gate_table[op];
+        }
     }
-}
-
-projector::projector(bool is_p0) : single_component{matrix{2, 2}, "P", 0} {
-    if (!is_p0) {
-        m.set_value(1, 1, std::complex<double>{1, 0});
-    } else {
-        m.set_value(2, 2, std::complex<double>{1, 0});
+    return nullptr;
+}
+
+matrix rotation_matrix(gate_opcode op, double angle) {
+    const double c = std::cos(angle / 2);
+    const double s = std::sin(angle / 2);
+    switch (op) {
+        case gate_opcode::rx:
+        case gate_opcode::crx:
+            return make_2x2(c, std::complex<double>{0, -s}, std::complex<double>{0, -s}, c);
+        case gate_opcode::ry:
+        case gate_opcode::cry:
+            return make_2x2(c, -s, s, c);
+        case gate_opcode::rz:
+        case gate_opcode::crz:
+            return make_2x2(std::complex<double>{c, -s}, 0, 0, std::complex<double>{c, s});
+        case gate_opcode::phase:
+        case gate_opcode::cphase:
+            return make_2x2(1, 0, 0, std::polar(1.0, angle));
+        default:
+            throw std::invalid_argument("Not a rotation gate.");
     }
 }
 
-// Multi-qubit component contructor
-multi_component::multi_component(matrix mat, std::string sym, int c, int t, int qs) : component{mat, sym}, control{c}, target{t}, qubits{qs} {}
-
-int multi_component::get_target() {
-    return target;
-}
-
-int multi_component::get_control() {
-    return control;
-}
-
-matrix multi_component::compute_tensor_product(const std::vector<matrix> &product_vector) {
-    matrix product = product_vector.back();
-    for (int i = product_vector.size() - 2; i >= 0; --i) {
-        product = product.tensor_product(product_vector[i]);
+matrix component_matrix(const component &comp) {
+    if (get_gate_info(comp.op).parameterized) {
+        return rotation_matrix(comp.op, comp.angle);
     }
-    return product;
+    return get_gate_matrix(comp.matrix_id);
 }
 
-matrix multi_component::construct_controlled_matrix(const matrix& gate_matrix) {
-    int matrix_size = 1 << qubits;
-    m.set_dimensions(matrix_size, matrix_size);
-
-    identity id(2);
-    projector p0(0);
-    projector p1(1);
-
-    std::vector<matrix> product_vector1;
-    std::vector<matrix> product_vector2;
-
-    for (int i = 0; i < qubits; ++i) {
-        if (i == control) {
-            product_vector1.push_back(p0.get_matrix());
-            product_vector2.push_back(p1.get_matrix());
-        } else if (i == target) {
-            product_vector1.push_back(id.get_matrix());
-            product_vector2.push_back(gate_matrix);
-        } else {
-            product_vector1.push_back(id.get_matrix());
-            product_vector2.push_back(id.get_matrix());
+// Validates the name and qubits of a new component; parameterized selects rotations or fixed gates
+static component build_component(const std::string &name, const std::vector<int> &qubits, int register_qubits,
+                                 bool parameterized) {
+    const gate_info* found = find_gate_info(name);
+    if (found == nullptr) {
+        throw std::invalid_argument("Unknown component: " + name);
+    }
+    const gate_info& info = *found;
+    if (info.parameterized != parameterized) {
+        throw std::invalid_argument(parameterized ? "Component takes no angle: " + name : "Component needs an angle: " + name);
+    }
+    if (qubits.size() != (info.controlled ? 2u : 1u)) {
+        throw std::invalid_argument("Wrong number of qubits for component: " + name);
+    }
+    for (int q : qubits) {
+        if (q < 0 || q >= register_qubits) {
+            throw std::out_of_range("Qubit index out of range for component: " + name);
         }
     }
-
-    matrix product1 = compute_tensor_product(product_vector1);
-    matrix product2 = compute_tensor_product(product_vector2);
-
-    return product1 + product2;
-}
-
-controlled_x::controlled_x(int c, int t, int qs) : multi_component{matrix{2, 2}, "X", c, t, qs} {
-    pauli_x x_gate(1);
-    m = construct_controlled_matrix(x_gate.get_matrix());
-}
-
-controlled_y::controlled_y(int c, int t, int qs) : multi_component{matrix{2, 2}, "Y", c, t, qs} {
-    pauli_y y_gate(1);
-    m = construct_controlled_matrix(y_gate.get_matrix());
+    if (info.controlled && qubits[0] == qubits[1]) {
+        throw std::invalid_argument("Control and target must differ for component: " + name);
+    }
+    component comp;
+    comp.op = static_cast<gate_opcode>(found - gate_table);
+    comp.matrix_id = info.matrix_id;
+    comp.qubits[0] = qubits[0];
+    comp.qubits[1] = info.controlled ? qubits[1] : -1;
+    comp.parameter = -1;
+    comp.angle = 0;
+    return comp;
+}
+
+component make_component(const std::string &name, const std::vector<int> &qubits, int register_qubits) {
+    profile::scope timer{profile::gate_construction};
+    return build_component(name, qubits, register_qubits, false);
+}
+
+component make_rotation(const std::string &name, const std::vector<int> &qubits, int register_qubits, double angle,
+                        int parameter) {
+    profile::scope timer{profile::gate_construction};
+    component comp = build_component(name, qubits, register_qubits, true);
+    comp.parameter = parameter;
+    comp.angle = angle;
+    return comp;
+}
+
+gate_op to_gate_op(const component &comp, gate_list &list) {
+    const gate_info& info = get_gate_info(comp.op);
+    // Fixed gates share the table's matrix; only rotations need one of their own
+    const matrix* m = info.parameterized ? list.keep(rotation_matrix(comp.op, comp.angle)) : &get_gate_matrix(comp.matrix_id);
+    if (info.controlled) {
+        return gate_op{gate_op::controlled, {comp.qubits[0], comp.qubits[1]}, m, info.structure};
+    }
+    return gate_op{gate_op::single, {comp.qubits[0]}, m, info.structure};
 }
 
-controlled_z::controlled_z(int c, int t, int qs) : multi_component{matrix{2, 2}, "Z", c, t, qs} {
-    pauli_z z_gate(1);
-    m = construct_controlled_matrix(z_gate.get_matrix());
+kron_operator controlled_operator(const component &comp, int register_qubits) {
+    profile::scope timer{profile::gate_construction};
+    std::vector<matrix> idle(register_qubits, get_gate_matrix(identity_matrix_id));
+    std::vector<matrix> active = idle;
+    idle[comp.qubits[0]] = get_gate_matrix(projector0_matrix_id);
+    active[comp.qubits[0]] = get_gate_matrix(projector1_matrix_id);
+    active[comp.qubits[1]] = component_matrix(comp);
+    kron_operator op{idle};
+    op.add_term(active);
+    return op;
 }
-
-controlled_h::controlled_h(int c, int t, int qs) : multi_component{matrix{2, 2}, "H", c, t, qs} {
-    hadamard h_gate(1);
-    m = construct_controlled_matrix(h_gate.get_matrix());
-}
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "fusion.h"
+#include "kron_operator.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+// Local matrix of a gate, with qubits[j] as bit j of the row/column index
+static matrix local_matrix(const gate_op &op) {
+    if (op.kind != gate_op::controlled) {
+        return *op.m;
+    }
+    // Bit 0 is the control, bit 1 the target: identity when the control is clear, the gate when set
+    matrix local{4, 4};
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 4; c++) {
+            if ((r & 1) != (c & 1)) {
+                local.at(r, c) = 0;
+            } else if ((r & 1) == 0) {
+                local.at(r, c) = (r == c) ? 1 : 0;
+            } else {
+                local.at(r, c) = op.m->at(r >> 1, c >> 1);
+            }
+        }
+    }
+    return local;
+}
+
+matrix expand_matrix(const gate_op &op, const std::vector<int> &qubits) {
+    matrix local = local_matrix(op);
+    const int size = 1 << qubits.size();
+
+    // Position of each of the gate's qubits within the larger set
+    std::vector<int> positions;
+    int gate_mask = 0;
+    for (int q : op.qubits) {
+        int pos = static_cast<int>(std::find(qubits.begin(), qubits.end(), q) - qubits.begin());
+        if (pos == static_cast<int>(qubits.size())) {
+            throw std::invalid_argument("Gate qubit missing from expansion set.");
+        }
+        positions.push_back(pos);
+        gate_mask |= 1 << pos;
+    }
+
+    matrix expanded{size, size};
+    for (int r = 0; r < size; r++) {
+        for (int c = 0; c < size; c++) {
+            if ((r & ~gate_mask) != (c & ~gate_mask)) {  // Untouched qubits must agree
+                expanded.at(r, c) = 0;
+                continue;
+            }
+            int local_r = 0;
+            int local_c = 0;
+            for (std::size_t j = 0; j < positions.size(); j++) {
+                local_r |= ((r >> positions[j]) & 1) << j;
+                local_c |= ((c >> positions[j]) & 1) << j;
+            }
+            expanded.at(r, c) = local.at(local_r, local_c);
+        }
+    }
+    return expanded;
+}
+
+// A single or controlled gate as a lazy operator on a block, where bit j of the block index is qubits[j]
+static kron_operator block_operator(const gate_op &op, const std::vector<int> &qubits) {
+    std::vector<int> positions;
+    for (int q : op.qubits) {
+        positions.push_back(static_cast<int>(std::find(qubits.begin(), qubits.end(), q) - qubits.begin()));
+    }
+    matrix identity{2, 2};
+    std::vector<matrix> factors(qubits.size(), identity);
+    if (op.kind != gate_op::controlled) {
+        factors[positions[0]] = *op.m;
+        return kron_operator{factors};
+    }
+    // |0><0|_c (x) I + |1><1|_c (x) U_t
+    matrix projector{2, 2};
+    projector.at(0, 0) = 1;
+    projector.at(1, 1) = 0;
+    factors[positions[0]] = projector;
+    kron_operator controlled{factors};
+    projector.at(0, 0) = 0;
+    projector.at(1, 1) = 1;
+    factors[positions[0]] = projector;
+    factors[positions[1]] = *op.m;
+    controlled.add_term(factors);
+    return controlled;
+}
+
+// Groups each run of single-qubit gates on the same qubit; every other gate is a run of its own
+static std::vector<std::vector<std::size_t>> plan_single_runs(const std::vector<gate_op> &gates) {
+    std::vector<std::vector<std::size_t>> runs;
+    std::vector<int> pending;  // Index into runs of the open single-qubit run on each qubit (-1 if none)
+
+    for (std::size_t g = 0; g < gates.size(); g++) {
+        const gate_op& op = gates[g];
+        int highest = *std::max_element(op.qubits.begin(), op.qubits.end());
+        if (static_cast<int>(pending.size()) <= highest) {
+            pending.resize(highest + 1, -1);
+        }
+        if (op.kind == gate_op::single) {
+            int q = op.qubits[0];
+            if (pending[q] >= 0) {
+                runs[pending[q]].push_back(g);
+            } else {
+                pending[q] = static_cast<int>(runs.size());
+                runs.push_back({g});
+            }
+        } else {
+            for (int q : op.qubits) {  // Close runs on the qubits this gate touches
+                pending[q] = -1;
+            }
+            runs.push_back({g});
+        }
+    }
+    return runs;
+}
+
+// Product of one run, later gates multiplying from the left, computed into product; a lone gate is
+// returned unchanged
+static gate_op merge_run(const std::vector<std::size_t> &run, const std::vector<gate_op> &gates, matrix &product) {
+    gate_op merged = gates[run[0]];
+    if (run.size() == 1) {
+        return merged;
+    }
+    multiply_into(*gates[run[1]].m, *merged.m, product);
+    matrix scratch;  // Swapped with product so no later product allocates
+    for (std::size_t j = 2; j < run.size(); j++) {
+        multiply_into(*gates[run[j]].m, product, scratch);
+        std::swap(product, scratch);
+    }
+    merged.m = &product;
+    merged.structure = classify_structure(product);
+    return merged;
+}
+
+std::vector<fused_group> plan_fusion(const std::vector<gate_op> &gates, int max_qubits) {
+    if (max_qubits < 1 || max_qubits > max_dense_qubits) {
+        throw std::invalid_argument("Fusion width out of range.");
+    }
+    std::vector<fused_group> plan;
+    std::vector<int> block_qubits;
+    for (std::vector<std::size_t>& run : plan_single_runs(gates)) {
+        if (max_qubits == 1) {
+            plan.push_back(fused_group{{std::move(run)}});
+            continue;
+        }
+        std::vector<int> joined = block_qubits;
+        for (int q : gates[run[0]].qubits) {
+            if (std::find(joined.begin(), joined.end(), q) == joined.end()) {
+                joined.push_back(q);
+            }
+        }
+        if (plan.empty() || static_cast<int>(joined.size()) > max_qubits) {
+            plan.push_back(fused_group());
+            joined.assign(gates[run[0]].qubits.begin(), gates[run[0]].qubits.end());
+        }
+        plan.back().runs.push_back(std::move(run));
+        block_qubits = joined;
+    }
+    return plan;
+}
+
+gate_op build_fused_gate(const fused_group &group, const std::vector<gate_op> &gates, gate_list &out) {
+    matrix merged;
+    if (group.runs.size() == 1) {
+        gate_op op = merge_run(group.runs[0], gates, merged);  // Lone gates keep their specialised kernel
+        if (op.m == &merged) {
+            op.m = out.keep(std::move(merged));
+        }
+        return op;
+    }
+    std::vector<int> block_qubits;
+    matrix block;
+    matrix product;  // Scratch for the block product, swapped with block
+    for (const std::vector<std::size_t>& run : group.runs) {
+        const gate_op op = merge_run(run, gates, merged);
+        std::vector<int> joined = block_qubits;
+        for (int q : op.qubits) {
+            if (std::find(joined.begin(), joined.end(), q) == joined.end()) {
+                joined.push_back(q);
+            }
+        }
+        std::sort(joined.begin(), joined.end());
+        if (block_qubits.empty()) {
+            block = expand_matrix(op, joined);
+        } else {
+            if (joined.size() != block_qubits.size()) {
+                block = expand_matrix(gate_op{gate_op::dense, block_qubits, &block}, joined);
+            }
+            if (op.kind == gate_op::dense) {
+                multiply_into(expand_matrix(op, joined), block, product);
+                std::swap(block, product);
+            } else {
+                block_operator(op, joined).apply_in_place(block);  // O(4^k) per gate instead of a dense O(8^k) product
+            }
+        }
+        block_qubits = joined;
+    }
+    return gate_op{gate_op::dense, block_qubits, out.keep(std::move(block))};
+}
+
+gate_list fuse_gates(gate_list gates, int max_qubits) {
+    gate_list fused;
+    fused.matrices = std::move(gates.matrices);  // Lone gates keep pointing at their matrices
+    for (const fused_group& group : plan_fusion(gates.gates, max_qubits)) {
+        fused.gates.push_back(build_fused_gate(group, gates.gates, fused));
+    }
+    return fused;
+}
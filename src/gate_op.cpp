@@ -0,0 +1,131 @@
+#include "gate_op.h"
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+template <typename Range>
+gate_qubits make_qubits(const Range &qubits) {
+    if (qubits.size() > static_cast<std::size_t>(max_dense_qubits)) {
+        throw std::invalid_argument("Gate acts on more than " + std::to_string(max_dense_qubits) + " qubits.");
+    }
+    gate_qubits stored{};
+    for (int q : qubits) {
+        stored.index[stored.count++] = q;
+    }
+    return stored;
+}
+
+}
+
+gate_op::gate_op(op_kind kind, std::initializer_list<int> qubits, const matrix *m, gate_structure structure)
+    : kind{kind}, qubits{make_qubits(qubits)}, m{m}, structure{structure} {}
+
+gate_op::gate_op(op_kind kind, const std::vector<int> &qubits, const matrix *m)
+    : kind{kind}, qubits{make_qubits(qubits)}, m{m}, structure{classify_structure(*m)} {}
+
+gate_list::gate_list(const gate_list &other) : gates{other.gates}, matrices{other.matrices} {
+    // Point ops that referred to other's matrices at the copies
+    std::map<const matrix*, const matrix*> moved;
+    for (std::size_t i = 0; i < matrices.size(); i++) {
+        moved[&other.matrices[i]] = &matrices[i];
+    }
+    for (gate_op& op : gates) {
+        auto it = moved.find(op.m);
+        if (it != moved.end()) {
+            op.m = it->second;
+        }
+    }
+}
+
+gate_list& gate_list::operator=(gate_list other) {
+    std::swap(gates, other.gates);
+    std::swap(matrices, other.matrices);
+    return *this;
+}
+
+const matrix* gate_list::keep(matrix m) {
+    matrices.push_back(std::move(m));
+    return &matrices.back();
+}
+
+void gate_list::clear() {
+    gates.clear();
+    matrices.clear();
+}
+
+gate_structure classify_structure(const matrix &m) {
+    const std::complex<double> zero{0, 0};
+    bool diagonal = true;
+    bool unit_entries = true;
+    for (int r = 0; r < m.get_rows(); r++) {
+        int nonzeros = 0;
+        for (int c = 0; c < m.get_cols(); c++) {
+            if (m.at(r, c) != zero) {
+                nonzeros++;
+                diagonal = diagonal && (r == c);
+                unit_entries = unit_entries && (m.at(r, c) == std::complex<double>{1, 0});
+            }
+        }
+        if (nonzeros != 1) {
+            return gate_structure::dense;
+        }
+    }
+    // One non-zero per row; check columns are not repeated
+    for (int c = 0; c < m.get_cols(); c++) {
+        int nonzeros = 0;
+        for (int r = 0; r < m.get_rows(); r++) {
+            nonzeros += (m.at(r, c) != zero);
+        }
+        if (nonzeros != 1) {
+            return gate_structure::dense;
+        }
+    }
+    if (diagonal) {
+        return gate_structure::diagonal;
+    }
+    return unit_entries ? gate_structure::permutation : gate_structure::phase_permutation;
+}
+
+void append_diagonal_factors(const gate_op &op, std::vector<diagonal_factor> &factors) {
+    if (op.kind == gate_op::controlled) {
+        // Phases only apply where the control bit is set
+        const std::size_t control_bit = std::size_t{1} << op.qubits[0];
+        const std::size_t target_bit = std::size_t{1} << op.qubits[1];
+        for (int t = 0; t < 2; t++) {
+            std::complex<double> phase = op.m->at(t, t);
+            if (classify_phase(phase) != phase_one) {
+                factors.push_back(diagonal_factor{control_bit | target_bit, control_bit | (t ? target_bit : 0), phase, classify_phase(phase)});
+            }
+        }
+        return;
+    }
+    std::size_t mask = 0;
+    for (int q : op.qubits) {
+        mask |= std::size_t{1} << q;
+    }
+    for (int l = 0; l < op.m->get_rows(); l++) {
+        std::complex<double> phase = op.m->at(l, l);
+        if (classify_phase(phase) == phase_one) {
+            continue;
+        }
+        std::size_t value = 0;
+        for (std::size_t j = 0; j < op.qubits.size(); j++) {
+            if ((l >> j) & 1) {
+                value |= std::size_t{1} << op.qubits[j];
+            }
+        }
+        factors.push_back(diagonal_factor{mask, value, phase, classify_phase(phase)});
+    }
+}
+
+bool all_sign_flips(const std::vector<diagonal_factor> &factors) {
+    for (const diagonal_factor& factor : factors) {
+        if (factor.kind != phase_minus_one) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,6 +1,17 @@
 #include "input_handler.h"
 #include <iostream>
 #include <limits>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include "sampler.h"
+#include "stabilizer.h"
+#include "mps.h"
+#include "profiler.h"
+#include "checkpoint.h"
+#include "output_writer.h"
 
 // Function to print an error message based on an input string
 void error_msg(std::string message)
@@ -13,6 +24,7 @@ void error_msg(std::string message)
 
 matrix get_input_vector(std::vector<char> initial_states)
 {
+    profile::scope timer{profile::input};
     // Define matrices for |0> and |1> vector states
     matrix zero_ket{2,1};
     matrix one_ket{2,1};
@@ -39,10 +51,25 @@ matrix get_input_vector(std::vector<char> initial_states)
     return product;
 }
 
-int get_qubits_from_user() {
+// Input vector saved by --checkpoint, used in place of get_input_vector
+matrix load_input_vector(const std::string &path, int qubits) {
+    profile::scope timer{profile::input};
+    checkpoint_file saved{path};
+    if (saved.get_qubits() != qubits) {
+        throw std::invalid_argument("Initial state " + path + " has " + std::to_string(saved.get_qubits())
+                                    + " qubits but the circuit has " + std::to_string(qubits) + ".");
+    }
+    return saved.to_matrix();
+}
+
+int get_qubits_from_user(int max_qubits) {
     int qubits;
-    while (std::cout << "Enter number of qubits in circuit: " && (!(std::cin >> qubits) || qubits < 1)) {
-        error_msg("Error: Input must be a positive integer.");
+    while (std::cout << "Enter number of qubits in circuit: " && (!(std::cin >> qubits) || qubits < 1 || qubits > max_qubits)) {
+        if (max_qubits == std::numeric_limits<int>::max()) {
+            error_msg("Error: Input must be a positive integer.");
+        } else {
+            error_msg("Error: Input must be an integer from 1 to " + std::to_string(max_qubits) + " for this backend.");
+        }
     }
     return qubits;
 }
@@ -72,21 +99,30 @@ void print_library(const std::vector<std::string>& comp_library) {
     std::cout << "]" << std::endl << std::endl;
 }
 
+// Prompt for a component, listing the names in the library
+static std::string component_prompt(const std::vector<std::string>& comp_library) {
+    std::string prompt = "Enter name of component to add (";
+    for (std::size_t i = 0; i < comp_library.size(); i++) {
+        prompt += (i > 0 ? ", '" : "'") + comp_library[i] + "'";
+    }
+    return prompt + " OR type '0' to finish and compute): ";
+}
+
 std::string get_component_from_user(const std::vector<std::string>& comp_library) {
     std::string comp_name;
-    while (std::cout << "Enter name of component to add ('x', 'y', 'z', 'h', 'cx', 'cy', 'cz', 'ch' OR type '0' to finish and compute): " 
+    while (std::cout << component_prompt(comp_library) 
            && (!(std::cin >> comp_name) || (std::find(comp_library.begin(), comp_library.end(), comp_name) == comp_library.end() && comp_name != "0"))) {
         error_msg("Error: Component not in library.");
     }
     return comp_name;
 }
 
-void add_components(circuit& c, std::vector<component*>& comp_added, const std::vector<std::string>& comp_library, int qubits) {
+void add_components(circuit& c, const std::vector<std::string>& comp_library, int qubits) {
     while (true) {
         std::string comp_name;
 
         // Get user input for the component to add, ensuring it's in the library
-        while (std::cout << "Enter name of component to add ('x', 'y', 'z', 'h', 'cx', 'cy', 'cz', 'ch' OR type '0' to finish and compute): "
+        while (std::cout << component_prompt(comp_library)
                && (!(std::cin >> comp_name)
                || (std::find(comp_library.begin(), comp_library.end(), comp_name) == comp_library.end() && comp_name != "0"))) {
             error_msg("Error: Component not in library.");
@@ -94,7 +130,7 @@ void add_components(circuit& c, std::vector<component*>& comp_added, const std::
 
         // Exit if the user inputs '0'
         if (comp_name == "0") {
-            if (!comp_added.empty()) {
+            if (c.get_gate_count() > 0) {
                 break;
             } else {
                 error_msg("Error: Circuit cannot be empty.");
@@ -102,27 +138,42 @@ void add_components(circuit& c, std::vector<component*>& comp_added, const std::
             }
         }
 
-        if (comp_name == "cx" || comp_name == "cy" || comp_name == "cz" || comp_name == "ch") {
+        if (find_gate_info(comp_name)->controlled) {
             // Multi-qubit component
-            add_multi_qubit_component(c, comp_added, comp_name, qubits);
+            add_multi_qubit_component(c, comp_name, qubits);
         } else {
             // Single-qubit component
-            add_single_qubit_component(c, comp_added, comp_name, qubits);
+            add_single_qubit_component(c, comp_name, qubits);
         }
 
-        // Add the most recently inputted component to the circuit
-        c.add(comp_added.back());
-        c.order_reg();
-
-        // Print the current circuit diagram
+        // Print the current circuit diagram and, when the statevector is kept, its live output state
         std::cout << "Current circuit:" << std::endl;
         c.draw();
+        if (c.is_dense()) {
+            std::cout << "Current output: ψ = ";
+            c.print_braket(c.get_current_state());
+            std::cout << std::endl;
+        }
+        std::cout << std::endl;
         print_library(comp_library);
     }
 }
 
+// Adds a component on the chosen qubits, first asking for the angle of a rotation
+static void add_library_component(circuit& c, const std::string& comp_name, const std::vector<int>& comp_qubits, int qubits) {
+    if (!find_gate_info(comp_name)->parameterized) {
+        c.add(make_component(comp_name, comp_qubits, qubits));
+        return;
+    }
+    double angle;
+    while (std::cout << "Rotation angle in radians? " && (!(std::cin >> angle) || !std::isfinite(angle))) {
+        error_msg("Error: Invalid angle entered.");
+    }
+    c.add(make_rotation(comp_name, comp_qubits, qubits, angle));
+}
+
 // Helper function to add single-qubit components
-void add_single_qubit_component(circuit& c, std::vector<component*>& comp_added, const std::string& comp_name, int qubits) {
+void add_single_qubit_component(circuit& c, const std::string& comp_name, int qubits) {
     int qubit_input;
 
     // Get user input for qubit selection
@@ -131,19 +182,11 @@ void add_single_qubit_component(circuit& c, std::vector<component*>& comp_added,
         error_msg("Error: Invalid qubit entered.");
     }
 
-    if (comp_name == "x") {
-        comp_added.push_back(new pauli_x(qubit_input));
-    } else if (comp_name == "y") {
-        comp_added.push_back(new pauli_y(qubit_input));
-    } else if (comp_name == "z") {
-        comp_added.push_back(new pauli_z(qubit_input));
-    } else if (comp_name == "h") {
-        comp_added.push_back(new hadamard(qubit_input));
-    }
+    add_library_component(c, comp_name, {qubit_input}, qubits);
 }
 
 // Helper function to add multi-qubit components
-void add_multi_qubit_component(circuit& c, std::vector<component*>& comp_added, const std::string& comp_name, int qubits) {
+void add_multi_qubit_component(circuit& c, const std::string& comp_name, int qubits) {
     int control_input, target_input;
 
     // Get validated user input for control qubit
@@ -158,38 +201,254 @@ void add_multi_qubit_component(circuit& c, std::vector<component*>& comp_added,
         error_msg("Error: Invalid target qubit entered.");
     }
 
-    if (comp_name == "cx") {
-        comp_added.push_back(new controlled_x(control_input, target_input, qubits));
-    } else if (comp_name == "cy") {
-        comp_added.push_back(new controlled_y(control_input, target_input, qubits));
-    } else if (comp_name == "cz") {
-        comp_added.push_back(new controlled_z(control_input, target_input, qubits));
-    } else if (comp_name == "ch") {
-        comp_added.push_back(new controlled_h(control_input, target_input, qubits));
+    add_library_component(c, comp_name, {control_input, target_input}, qubits);
+}
+
+// Prints a column vector as the row "ψᵀ = [(re,im) ...]" straight from its storage, without a transposed copy
+static void print_transposed(const matrix &column) {
+    profile::scope timer{profile::output};
+    output_writer out{std::cout};
+    out.put("ψᵀ = [");
+    const std::complex<double>* values = column.data();
+    for (int i = 0; i < column.get_rows(); i++) {
+        if (i > 0) {
+            out.put(' ');
+        }
+        out.put('(');
+        out.put_number(values[i].real(), 6);
+        out.put(',');
+        out.put_number(values[i].imag(), 6);
+        out.put(')');
     }
+    out.put("]\n");
 }
 
-void calculate_and_display_results(circuit& c, const matrix& input_vector) {
+// Runs a backend that keeps its own state and prints the final circuit and that backend's output line
+template <typename Simulate>
+static void display_backend_results(circuit& c, const std::string& description, Simulate simulate,
+                                    const sim_options& options) {
+    std::cout << "Performing calculation (" << description << ")..." << std::endl << std::endl;
+    auto state = simulate();
+    std::cout << "---------- RESULTS ----------" << std::endl << std::endl;
+    std::cout << "Final circuit:" << std::endl;
+    c.draw();
+    std::cout << "OUTPUT: " << std::endl;
+    display_backend_output(state, options);
+}
+
+void calculate_and_display_results(circuit& c, const matrix& input_vector, const sim_options& options) {
+    profile::scope timer{profile::output};  // Simulation and sampling below carve out their own time
+    backend_kind backend = resolve_backend(options, c.get_qubits(), c.is_clifford());
+    if (backend == backend_kind::stabilizer) {
+        std::cout << "Performing calculation (stabilizer tableau)..." << std::endl << std::endl;
+        stabilizer_tableau tableau = c.simulate_stabilizer();
+        std::cout << "---------- RESULTS ----------" << std::endl << std::endl;
+        std::cout << "Final circuit:" << std::endl;
+        c.draw();
+        std::cout << "OUTPUT stabilizers:" << std::endl;
+        display_stabilizers(tableau);
+        if (options.shots > 0) {
+            display_measurements(tableau, options);
+        }
+        return;
+    }
+    if (backend == backend_kind::mps) {
+        display_backend_results(c, "matrix product state", [&]() { return c.simulate_mps(options); }, options);
+        return;
+    }
+    if (backend == backend_kind::mmap) {
+        display_backend_results(c, "out-of-core statevector", [&]() { return c.simulate_mmap(options); }, options);
+        return;
+    }
+    if (backend == backend_kind::sharded) {
+        display_backend_results(c, std::to_string(options.shards) + " shard processes",
+                                [&]() { return c.simulate_sharded(options); }, options);
+        return;
+    }
+
     // Calculate the output state vector of the circuit
     std::cout << "Performing calculation..." << std::endl << std::endl;
-    matrix output_vector = c.get_resultant_matrix() * input_vector;
+    matrix output_vector = c.simulate(options);
 
     // Print the final circuit diagram
     std::cout << "---------- RESULTS ----------" << std::endl << std::endl;
     std::cout << "Final circuit:" << std::endl;
     c.draw();
     
-    // Print input state in vector and bra-ket format
+    // Print input state in vector and bra-ket format; the full vector is left out when the output is filtered
     std::cout << "INPUT: " << std::endl;
-    std::cout << "ψᵀ = " << input_vector.get_transpose();  // Transpose of input vector
-    std::cout << "ψ = ";
-    c.print_braket(input_vector);  // Bra-ket notation for input vector
+    if (!options.output.is_filtered()) {
+        print_transposed(input_vector);
+    }
+    std::cout << braket_label(options.output);
+    c.print_braket(input_vector, options.output);  // Bra-ket notation for input vector
     std::cout << std::endl;
 
     // Print output state in vector and bra-ket format
     std::cout << "OUTPUT: " << std::endl;
-    std::cout << "ψᵀ = " << output_vector.get_transpose();  // Transpose of output vector
-    std::cout << "ψ = ";
-    c.print_braket(output_vector);  // Bra-ket notation for output vector
+    if (!options.output.is_filtered()) {
+        print_transposed(output_vector);
+    }
+    std::cout << braket_label(options.output);
+    c.print_braket(output_vector, options.output);  // Bra-ket notation for output vector
     std::cout << std::endl;
-}
\ No newline at end of file
+
+    if (options.shots > 0) {
+        display_measurements(output_vector, options);
+    }
+}
+
+// Runs every computational basis input through the circuit as one batch and prints each output
+void calculate_and_display_batch_results(circuit& c, int qubits, const sim_options& options) {
+    profile::scope timer{profile::output};
+    if (qubits > max_all_inputs_qubits) {
+        throw std::invalid_argument("--all-inputs supports at most " + std::to_string(max_all_inputs_qubits) + " qubits.");
+    }
+    std::cout << "Performing batch calculation over all " << (1 << qubits) << " basis inputs..." << std::endl << std::endl;
+    std::vector<matrix> inputs;
+    for (int k = 0; k < (1 << qubits); k++) {
+        std::vector<char> states(qubits);
+        for (int q = 0; q < qubits; q++) {
+            states[q] = ((k >> q) & 1) ? '1' : '0';
+        }
+        inputs.push_back(get_input_vector(states));
+    }
+    std::vector<matrix> outputs = c.simulate_batch(inputs, options);
+
+    std::cout << "---------- RESULTS ----------" << std::endl << std::endl;
+    std::cout << "Final circuit:" << std::endl;
+    c.draw();
+    for (std::size_t k = 0; k < outputs.size(); k++) {
+        std::cout << braket_label(options.output);
+        c.print_braket(inputs[k], options.output);
+        std::cout << "-> " << braket_label(options.output);
+        c.print_braket(outputs[k], options.output);
+        std::cout << std::endl;
+    }
+}
+// Prints a histogram of sampled bitstrings, highest measured qubit first to match the ket order
+static void print_histogram(std::vector<int> measured, int qubits, const std::map<std::string, std::uint64_t>& counts, int shots) {
+    profile::scope timer{profile::output};
+    if (measured.empty()) {
+        for (int q = 0; q < qubits; q++) {
+            measured.push_back(q);
+        }
+    }
+    std::sort(measured.begin(), measured.end());
+    std::cout << "MEASUREMENTS (" << shots << " shots, qubits";
+    for (auto q = measured.rbegin(); q != measured.rend(); ++q) {
+        std::cout << " " << *q;
+    }
+    std::cout << "):" << std::endl;
+    std::ios::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(4);
+    for (const auto& entry : counts) {
+        std::cout << "|" << entry.first << "> " << entry.second << " ("
+                  << static_cast<double>(entry.second) / shots << ")" << std::endl;
+    }
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+}
+
+// Samples the requested number of shots from a state and prints the histogram of observed bitstrings
+void display_measurements(const matrix& state, const sim_options& options) {
+    profile::scope timer{profile::sampling};
+    sampler s{state, options.measured};
+    std::mt19937_64 rng{options.fixed_seed ? options.seed : std::random_device{}()};
+    std::vector<std::uint64_t> counts = s.sample_counts(options.shots, rng);
+
+    const int k = static_cast<int>(s.get_measured().size());
+    std::map<std::string, std::uint64_t> histogram;
+    std::string bits(k, '0');
+    for (std::size_t outcome = 0; outcome < counts.size(); outcome++) {
+        if (counts[outcome] == 0) {
+            continue;
+        }
+        for (int j = 0; j < k; j++) {
+            bits[k - 1 - j] = ((outcome >> j) & 1) ? '1' : '0';
+        }
+        histogram[bits] = counts[outcome];
+    }
+    print_histogram(s.get_measured(), k, histogram, options.shots);
+}
+
+// Same histogram for a stabilizer state, sampled from its outcome subspace without any amplitudes
+void display_measurements(const stabilizer_tableau& tableau, const sim_options& options) {
+    profile::scope timer{profile::sampling};
+    std::mt19937_64 rng{options.fixed_seed ? options.seed : std::random_device{}()};
+    print_histogram(options.measured, tableau.get_qubits(), tableau.sample_counts(options.shots, options.measured, rng), options.shots);
+}
+
+void display_measurements(const mps_state& state, const sim_options& options) {
+    profile::scope timer{profile::sampling};
+    std::mt19937_64 rng{options.fixed_seed ? options.seed : std::random_device{}()};
+    print_histogram(options.measured, state.get_qubits(), state.sample_counts(options.shots, options.measured, rng), options.shots);
+}
+
+void display_measurements(const mmap_statevector& state, const sim_options& options) {
+    profile::scope timer{profile::sampling};
+    std::mt19937_64 rng{options.fixed_seed ? options.seed : std::random_device{}()};
+    print_histogram(options.measured, state.get_qubits(), state.sample_counts(options.shots, options.measured, rng), options.shots);
+}
+
+// Pass counts of an out-of-core result
+static void print_summary(const mmap_statevector& state) {
+    std::cout << "mmap " << state.get_gate_passes() << " gate passes, " << state.get_swap_passes() << " swap passes";
+}
+
+void display_measurements(const sharded_statevector& state, const sim_options& options) {
+    profile::scope timer{profile::sampling};
+    std::mt19937_64 rng{options.fixed_seed ? options.seed : std::random_device{}()};
+    print_histogram(options.measured, state.get_qubits(), state.sample_counts(options.shots, options.measured, rng), options.shots);
+}
+
+// Shard count and how often shards had to exchange amplitudes
+static void print_summary(const sharded_statevector& state) {
+    std::cout << state.get_shards() << " shards, " << state.get_gate_runs() << " gate runs, " << state.get_exchanges()
+              << " exchanges";
+}
+
+// Bond dimension and accumulated truncation error of an MPS result
+static void print_summary(const mps_state& state) {
+    std::cout << "mps max bond " << state.get_max_bond() << ", truncation error " << state.get_truncation_error();
+}
+
+// Output line of a backend that keeps its own state: the amplitudes when the register is small enough to read,
+// then the backend summary in brackets, then the sampled shots
+template <typename State>
+static void display_state_output(const State& state, const sim_options& options) {
+    {
+        profile::scope timer{profile::output};
+        if (state.get_qubits() <= max_printed_amplitude_qubits) {
+            std::cout << braket_label(options.output);
+            print_braket(state.to_matrix(), state.get_qubits(), options.output);
+        }
+        std::cout << "(";
+        print_summary(state);
+        std::cout << ")" << std::endl;
+    }
+    if (options.shots > 0) {
+        display_measurements(state, options);
+    }
+}
+
+void display_backend_output(const mps_state& state, const sim_options& options) {
+    display_state_output(state, options);
+}
+
+void display_backend_output(const mmap_statevector& state, const sim_options& options) {
+    display_state_output(state, options);
+}
+
+void display_backend_output(const sharded_statevector& state, const sim_options& options) {
+    display_state_output(state, options);
+}
+
+// Prints the stabilizer generators of a tableau state, one per line
+void display_stabilizers(const stabilizer_tableau& tableau) {
+    profile::scope timer{profile::output};
+    for (const std::string& generator : tableau.get_stabilizers()) {
+        std::cout << "  " << generator << std::endl;
+    }
+}
@@ -0,0 +1,106 @@
+#include "kron_operator.h"
+#include <algorithm>
+#include <stdexcept>
+#include "thread_pool.h"
+
+// Returns k with a zero bit inserted at position bit (higher bits shifted up)
+static inline std::size_t insert_zero_bit(std::size_t k, int bit) {
+    std::size_t low_mask = (std::size_t{1} << bit) - 1;
+    return ((k & ~low_mask) << 1) | (k & low_mask);
+}
+
+static bool is_identity(const matrix &factor) {
+    return factor.at(0, 0) == 1.0 && factor.at(0, 1) == 0.0 && factor.at(1, 0) == 0.0 && factor.at(1, 1) == 1.0;
+}
+
+kron_operator::kron_operator(int qubits) : qubits{qubits} {
+    if (qubits < 1 || qubits > 30) {
+        throw std::invalid_argument("Operator must act on 1 to 30 qubits.");
+    }
+}
+
+kron_operator::kron_operator(const std::vector<matrix> &factors) : kron_operator(static_cast<int>(factors.size())) {
+    add_term(factors);
+}
+
+void kron_operator::add_term(const std::vector<matrix> &factors) {
+    if (static_cast<int>(factors.size()) != qubits) {
+        throw std::invalid_argument("A Kronecker term needs one factor per qubit.");
+    }
+    std::vector<int> moving;
+    for (int q = 0; q < qubits; q++) {
+        if (factors[q].get_rows() != 2 || factors[q].get_cols() != 2) {
+            throw std::invalid_argument("Kronecker factors must be 2x2.");
+        }
+        if (!is_identity(factors[q])) {
+            moving.push_back(q);
+        }
+    }
+    terms.push_back(factors);
+    active.push_back(moving);
+}
+
+// Accessors
+int kron_operator::get_qubits() const {
+    return qubits;
+}
+
+std::size_t kron_operator::get_term_count() const {
+    return terms.size();
+}
+
+// Applies each non-identity factor of one term to row pairs (i, i + 2^q) of m, every column at once
+void kron_operator::apply_term(std::size_t term, matrix &m) const {
+    const std::size_t cols = m.get_cols();
+    std::complex<double>* rows = m.data();
+    for (int q : active[term]) {
+        const matrix& u = terms[term][q];
+        const std::complex<double> u00 = u.at(0, 0), u01 = u.at(0, 1), u10 = u.at(1, 0), u11 = u.at(1, 1);
+        const std::size_t stride = (std::size_t{1} << q) * cols;
+        parallel_sweep((std::size_t{1} << (qubits - 1)) * cols, [=](std::size_t begin, std::size_t end) {
+            for (std::size_t e = begin; e < end; e++) {
+                const std::size_t i = insert_zero_bit(e / cols, q) * cols + e % cols;
+                const std::complex<double> a0 = rows[i];
+                const std::complex<double> a1 = rows[i + stride];
+                rows[i] = u00 * a0 + u01 * a1;
+                rows[i + stride] = u10 * a0 + u11 * a1;
+            }
+        });
+    }
+}
+
+void kron_operator::apply_in_place(matrix &m) const {
+    if (m.get_rows() != (1 << qubits)) {
+        throw std::invalid_argument("Operand must have 2^n rows.");
+    }
+    if (terms.empty()) {
+        std::fill(m.data(), m.data() + static_cast<std::size_t>(m.get_rows()) * m.get_cols(), std::complex<double>{0, 0});
+        return;
+    }
+    if (terms.size() == 1) {
+        apply_term(0, m);
+        return;
+    }
+    matrix sum = m;
+    apply_term(0, sum);
+    matrix branch;
+    for (std::size_t t = 1; t < terms.size(); t++) {
+        branch = m;
+        apply_term(t, branch);
+        add_into(sum, branch, sum);
+    }
+    m = std::move(sum);
+}
+
+matrix kron_operator::apply(const matrix &m) const {
+    matrix result = m;
+    apply_in_place(result);
+    return result;
+}
+
+matrix kron_operator::to_matrix() const {
+    const int size = 1 << qubits;
+    matrix dense{size, size};  // Identity, so applying the operator leaves its dense form
+    apply_in_place(dense);
+    return dense;
+}
@@ -1,27 +1,128 @@
 #include "matrix.h"
 #include <iostream>
 #include <limits>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
 
-// Constructor
-matrix::matrix(int r, int c) : rows{r}, columns{c}, matrix_data{new std::complex<double>[r * c]} {
-    for (int i = 1; i <= rows; i++) {
-        for (int j = 1; j <= columns; j++) {
-            if (i == j) {
-                matrix_data[index(i, j)] = std::complex<double>(1, 0);
+// Blocks larger than this (in elements) always go straight back to the heap
+static const std::size_t max_pooled_elements = std::size_t{1} << 16;
+// Most bytes of free blocks kept per thread
+static const std::size_t max_pooled_bytes = std::size_t{64} << 20;
+
+static std::atomic<std::uint64_t> heap_allocations{0};
+static std::atomic<std::uint64_t> pool_reuses{0};
+static std::atomic<std::uint64_t> heap_bytes{0};
+
+// Per-thread arena state: nesting depth and free blocks keyed by element count
+struct arena_state
+{
+    int depth = 0;
+    std::size_t pooled_bytes = 0;
+    std::unordered_map<std::size_t, std::vector<std::complex<double>*>> free_blocks;
+
+    void release() {
+        for (auto& entry : free_blocks) {
+            for (std::complex<double>* block : entry.second) {
+                ::operator delete[](block);
             }
         }
+        free_blocks.clear();
+        pooled_bytes = 0;
     }
+    ~arena_state() { release(); }
+};
+
+static arena_state& local_arena() {
+    static thread_local arena_state state;
+    return state;
 }
 
-// Copy Constructor
-matrix::matrix(const matrix &m) : rows{m.rows}, columns{m.columns}, matrix_data{new std::complex<double>[m.rows * m.columns]} {
-    for (int i = 0; i < (rows * columns); i++) {
-        matrix_data[i] = m.matrix_data[i];
+// Uninitialised storage for n elements, recycled from the arena when possible
+static std::complex<double>* acquire_block(std::size_t n) {
+    if (n == 0) {
+        return nullptr;
+    }
+    arena_state& arena = local_arena();
+    if (arena.depth > 0) {
+        auto it = arena.free_blocks.find(n);
+        if (it != arena.free_blocks.end() && !it->second.empty()) {
+            std::complex<double>* block = it->second.back();
+            it->second.pop_back();
+            arena.pooled_bytes -= n * sizeof(std::complex<double>);
+            pool_reuses.fetch_add(1, std::memory_order_relaxed);
+            return block;
+        }
+    }
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    heap_bytes.fetch_add(n * sizeof(std::complex<double>), std::memory_order_relaxed);
+    return static_cast<std::complex<double>*>(::operator new[](n * sizeof(std::complex<double>)));
+}
+
+static void release_block(std::complex<double>* block, std::size_t n) {
+    if (block == nullptr) {
+        return;
+    }
+    arena_state& arena = local_arena();
+    const std::size_t bytes = n * sizeof(std::complex<double>);
+    if (arena.depth > 0 && n <= max_pooled_elements && arena.pooled_bytes + bytes <= max_pooled_bytes) {
+        arena.free_blocks[n].push_back(block);
+        arena.pooled_bytes += bytes;
+        return;
+    }
+    ::operator delete[](block);
+}
+
+static std::size_t element_count(int r, int c) {
+    return static_cast<std::size_t>(r) * static_cast<std::size_t>(c);
+}
+
+matrix_alloc_stats get_matrix_alloc_stats() {
+    return matrix_alloc_stats{heap_allocations.load(), pool_reuses.load(), heap_bytes.load()};
+}
+
+void reset_matrix_alloc_stats() {
+    heap_allocations = 0;
+    pool_reuses = 0;
+    heap_bytes = 0;
+}
+
+matrix_arena::matrix_arena() {
+    local_arena().depth++;
+}
+
+matrix_arena::~matrix_arena() {
+    arena_state& arena = local_arena();
+    if (--arena.depth == 0) {
+        arena.release();
     }
 }
 
+void matrix::reshape(int r, int c) {
+    if (element_count(r, c) != element_count(rows, columns)) {
+        release_block(matrix_data, element_count(rows, columns));
+        matrix_data = acquire_block(element_count(r, c));
+    }
+    rows = r;
+    columns = c;
+}
+
+// Constructor
+matrix::matrix(int r, int c) : matrix_data{acquire_block(element_count(r, c))}, rows{r}, columns{c} {
+    std::fill(matrix_data, matrix_data + element_count(r, c), std::complex<double>{0, 0});
+    for (int i = 0; i < std::min(rows, columns); i++) {
+        matrix_data[i + i * columns] = std::complex<double>(1, 0);
+    }
+}
+
+// Copy Constructor
+matrix::matrix(const matrix &m) : matrix_data{acquire_block(element_count(m.rows, m.columns))}, rows{m.rows}, columns{m.columns} {
+    std::copy(m.matrix_data, m.matrix_data + element_count(rows, columns), matrix_data);
+}
+
 // Move Constructor
-matrix::matrix(matrix&& m) noexcept : rows{m.rows}, columns{m.columns}, matrix_data{m.matrix_data} {
+matrix::matrix(matrix&& m) noexcept : matrix_data{m.matrix_data}, rows{m.rows}, columns{m.columns} {
     m.rows = 0;
     m.columns = 0;
     m.matrix_data = nullptr;
@@ -29,7 +130,7 @@ matrix::matrix(matrix&& m) noexcept : rows{m.rows}, columns{m.columns}, matrix_d
 
 // Destructor
 matrix::~matrix() {
-    delete[] matrix_data;
+    release_block(matrix_data, element_count(rows, columns));
 }
 
 // Accessors
@@ -46,9 +147,8 @@ void matrix::set_dimensions(const int &r, const int &c) {
     if (r < 0 || c < 0) {
         std::cout << "Error: dimensions not valid.";
     } else {
-        rows = r;
-        columns = c;
-        matrix_data = new std::complex<double>[r * c];
+        reshape(r, c);
+        std::fill(matrix_data, matrix_data + element_count(r, c), std::complex<double>{0, 0});
     }
 }
 
@@ -86,44 +186,108 @@ matrix matrix::get_transpose() const {
 
 // Arithmetic Operators
 matrix matrix::operator+(const matrix &m) const {
-    matrix output(rows, columns);
-    if (rows == m.rows && columns == m.columns) {
-        for (int i = 0; i < rows * columns; i++) {
-            output.matrix_data[i] = matrix_data[i] + m.matrix_data[i];
-        }
-    } else {
-        std::cout << "Error: cannot perform addition as dimensions do not match."; exit(1);
-    }
+    matrix output;
+    add_into(*this, m, output);
     return output;
 }
 matrix matrix::operator-(const matrix &m) const {
-    matrix output(rows, columns);
-    if (rows == m.rows && columns == m.columns) {
-        for (int i = 0; i < rows * columns; i++) {
-            output.matrix_data[i] = matrix_data[i] - m.matrix_data[i];
-        }
-    } else {
+    if (rows != m.rows || columns != m.columns) {
         std::cout << "Error: cannot perform subtraction as dimensions do not match."; exit(1);
     }
+    matrix output;
+    output.reshape(rows, columns);
+    for (std::size_t i = 0; i < element_count(rows, columns); i++) {
+        output.matrix_data[i] = matrix_data[i] - m.matrix_data[i];
+    }
     return output;
 }
 matrix matrix::operator*(const matrix &m) const {
-    matrix output(rows, m.columns);
-    if (columns == m.rows) {
-        for (int i = 1; i <= rows; i++) {
-            for (int j = 1; j <= m.columns; j++) {
-                std::complex<double> sum{0,0};
-                for (int k = 1; k <= columns; k++) {
-                    sum = sum + (get_value(i,k) * m.get_value(k,j));
+    matrix output;
+    multiply_into(*this, m, output);
+    return output;
+}
+
+void add_into(const matrix &a, const matrix &b, matrix &out) {
+    if (a.rows != b.rows || a.columns != b.columns) {
+        std::cout << "Error: cannot perform addition as dimensions do not match."; exit(1);
+    }
+    out.reshape(a.rows, a.columns);  // Same element count, so an aliased operand keeps its block
+    for (std::size_t i = 0; i < element_count(a.rows, a.columns); i++) {
+        out.matrix_data[i] = a.matrix_data[i] + b.matrix_data[i];
+    }
+}
+
+void multiply_into(const matrix &a, const matrix &b, matrix &out) {
+    if (a.columns != b.rows) {
+        std::cout << "Error: cannot perform multiplication as dimensions are not compatible."; exit(1);
+    }
+    if (&out == &a || &out == &b) {
+        std::cout << "Error: multiply_into output must not alias an operand."; exit(1);
+    }
+    out.reshape(a.rows, b.columns);
+    std::complex<double>* product = out.matrix_data;
+    std::fill(product, product + element_count(a.rows, b.columns), std::complex<double>{0, 0});
+
+    // Tiled i-k-j loop order so the inner loop streams contiguous rows of b and out
+    const int block_size = matrix::block_size;
+    const int rows = a.rows;
+    const int columns = a.columns;
+    const int n_cols = b.columns;
+    for (int ii = 0; ii < rows; ii += block_size) {
+        const int i_end = std::min(ii + block_size, rows);
+        for (int kk = 0; kk < columns; kk += block_size) {
+            const int k_end = std::min(kk + block_size, columns);
+            for (int jj = 0; jj < n_cols; jj += block_size) {
+                const int j_end = std::min(jj + block_size, n_cols);
+                for (int i = ii; i < i_end; i++) {
+                    std::complex<double>* out_row = product + i * n_cols;
+                    for (int k = kk; k < k_end; k++) {
+                        const std::complex<double> value = a.matrix_data[k + i * columns];
+                        if (value == std::complex<double>{0, 0}) {  // Gate matrices are mostly zeros
+                            continue;
+                        }
+                        // Real arithmetic avoids the NaN-recovery path of std::complex multiply
+                        const double a_re = value.real();
+                        const double a_im = value.imag();
+                        const double* b_row = reinterpret_cast<const double*>(b.matrix_data + k * n_cols);
+                        double* out_d = reinterpret_cast<double*>(out_row);
+                        for (int j = jj; j < j_end; j++) {
+                            const double b_re = b_row[2 * j];
+                            const double b_im = b_row[2 * j + 1];
+                            out_d[2 * j] += a_re * b_re - a_im * b_im;
+                            out_d[2 * j + 1] += a_re * b_im + a_im * b_re;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void kron_into(const matrix &a, const matrix &b, matrix &out) {
+    if (&out == &a || &out == &b) {
+        std::cout << "Error: kron_into output must not alias an operand."; exit(1);
+    }
+    out.reshape(a.rows * b.rows, a.columns * b.columns);
+    const int out_cols = a.columns * b.columns;
+
+    // Each output row is a row of b scaled by successive entries of one row of a
+    for (int i = 0; i < a.rows; i++) {
+        for (int k = 0; k < b.rows; k++) {
+            std::complex<double>* out_row = out.matrix_data + (i * b.rows + k) * out_cols;
+            const std::complex<double>* b_row = b.matrix_data + k * b.columns;
+            for (int j = 0; j < a.columns; j++) {
+                const double a_re = a.matrix_data[j + i * a.columns].real();
+                const double a_im = a.matrix_data[j + i * a.columns].imag();
+                double* out_block = reinterpret_cast<double*>(out_row + j * b.columns);
+                const double* b_block = reinterpret_cast<const double*>(b_row);
+                for (int l = 0; l < b.columns; l++) {
+                    out_block[2 * l] = a_re * b_block[2 * l] - a_im * b_block[2 * l + 1];
+                    out_block[2 * l + 1] = a_re * b_block[2 * l + 1] + a_im * b_block[2 * l];
                 }
-                output.set_value(i,j,sum);
-                sum = std::complex<double>{0,0};
             }
         }
-    } else {
-        std::cout << "Error: cannot perform multiplication as dimensions are not compatible."; exit(1);
     }
-    return output;
 }
 
 // Overloaded << operator
@@ -166,13 +330,8 @@ std::istream& operator>>(std::istream &is, matrix &m) {
  // Overload copy assignment operator
 matrix& matrix::operator=(const matrix &m) {
     if (this != &m) {
-        delete[] matrix_data;
-        rows = m.rows;
-        columns = m.columns;
-        matrix_data = new std::complex<double>[rows * columns];
-        for (int i = 0; i < rows * columns; i++) {
-            matrix_data[i] = m.matrix_data[i];
-        }
+        reshape(m.rows, m.columns);
+        std::copy(m.matrix_data, m.matrix_data + element_count(rows, columns), matrix_data);
     } else {
         std::cout << "Error: cannot copy matrix to itself" << std::endl;
     }
@@ -182,9 +341,9 @@ matrix& matrix::operator=(const matrix &m) {
 // Overload move assignment operator
 matrix& matrix::operator=(matrix &&m) noexcept {
     if (this != &m) {
+        release_block(matrix_data, element_count(rows, columns));
         rows = m.rows;
         columns = m.columns;
-        delete[] matrix_data;
         matrix_data = m.matrix_data;
         m.rows = 0;
         m.columns = 0;
@@ -198,17 +357,7 @@ matrix& matrix::operator=(matrix &&m) noexcept {
 
 // Calculate tensor product of matrix with input
 matrix matrix::tensor_product(const matrix &m) const {
-    matrix output{rows * m.rows, columns * m.columns};
-    for (int i = 1; i <= rows; i++) {
-        for (int j = 1; j <= columns; j++) {
-            for (int k = 1; k <= m.rows; k++) {
-                for (int l = 1; l <= m.columns; l++) {
-                    int row = (i - 1) * m.rows + k;
-                    int col = (j - 1) * m.columns + l;
-                    output.set_value(row, col, get_value(i, j) * m.get_value(k, l));
-                }
-            }
-        }
-    }
+    matrix output;
+    kron_into(*this, m, output);
     return output;
-}
\ No newline at end of file
+}
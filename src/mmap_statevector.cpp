@@ -0,0 +1,152 @@
+#include "mmap_statevector.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "profiler.h"
+
+static std::string system_error(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+mmap_statevector::mmap_statevector(const std::vector<char> &initial_states, int chunk_qubits, const std::string &dir)
+    : qubits{static_cast<int>(initial_states.size())}, layout{0, 0} {
+    if (qubits < 1 || qubits > max_mmap_qubits) {
+        throw std::invalid_argument("Out-of-core register must have 1 to " + std::to_string(max_mmap_qubits) + " qubits.");
+    }
+    if (chunk_qubits < 1) {
+        throw std::invalid_argument("Chunk size must be at least one qubit.");
+    }
+    const std::size_t start = basis_index(initial_states);
+    // Fused blocks must fit inside a chunk
+    this->chunk_qubits = std::min(qubits, std::max(chunk_qubits, max_dense_qubits));
+    layout = qubit_layout{qubits, this->chunk_qubits};
+    size = std::size_t{1} << qubits;
+    const std::size_t bytes = size * sizeof(std::complex<double>);
+
+    std::string base_dir = dir;
+    if (base_dir.empty()) {
+        const char* tmp = std::getenv("TMPDIR");
+        base_dir = tmp != nullptr ? tmp : "/tmp";
+    }
+    std::string path = base_dir + "/qc-statevector-XXXXXX";
+    std::vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    fd = mkstemp(name.data());
+    if (fd < 0) {
+        throw std::runtime_error(system_error("Cannot create statevector file in " + base_dir));
+    }
+    unlink(name.data());  // Removed by the OS once the mapping and descriptor are gone
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {  // Sparse, reads back as zeros
+        close(fd);
+        throw std::runtime_error(system_error("Cannot size statevector file"));
+    }
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error(system_error("Cannot map statevector file"));
+    }
+    madvise(mapped, bytes, MADV_SEQUENTIAL);
+    amplitudes = static_cast<std::complex<double>*>(mapped);
+
+    amplitudes[start] = std::complex<double>{1, 0};
+}
+
+mmap_statevector::~mmap_statevector() {
+    if (amplitudes != nullptr) {
+        munmap(amplitudes, size * sizeof(std::complex<double>));
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+mmap_statevector::mmap_statevector(mmap_statevector &&other) noexcept
+    : qubits{other.qubits}, chunk_qubits{other.chunk_qubits}, size{other.size}, amplitudes{other.amplitudes}, fd{other.fd},
+      layout{std::move(other.layout)},
+      gate_passes{other.gate_passes}, swap_passes{other.swap_passes} {
+    other.amplitudes = nullptr;
+    other.fd = -1;
+}
+
+// Accessors
+int mmap_statevector::get_qubits() const {
+    return qubits;
+}
+
+int mmap_statevector::get_chunk_qubits() const {
+    return chunk_qubits;
+}
+
+std::size_t mmap_statevector::get_size() const {
+    return size;
+}
+
+std::uint64_t mmap_statevector::get_gate_passes() const {
+    return gate_passes;
+}
+
+std::uint64_t mmap_statevector::get_swap_passes() const {
+    return swap_passes;
+}
+
+// Exchanges stored bits high (above the chunk) and low (inside it): for every pair of chunks differing only
+// in bit high, amplitudes with (high, low) = (0, 1) trade places with those at (1, 0)
+void mmap_statevector::swap_bits(int high, int low) {
+    profile::scope timer{profile::simulation};
+    const std::size_t chunk = std::size_t{1} << chunk_qubits;
+    const std::size_t chunk_bit = std::size_t{1} << (high - chunk_qubits);
+    const std::size_t chunks = size >> chunk_qubits;
+    for (std::size_t a = 0; a < chunks; a++) {
+        if (a & chunk_bit) {
+            continue;
+        }
+        swap_between_chunks(amplitudes + a * chunk, amplitudes + (a | chunk_bit) * chunk, low, 0, chunk >> 1);
+    }
+    swap_passes++;
+    profile::count_work(0, 2 * size * sizeof(std::complex<double>), 0);
+}
+
+// One streaming pass: every chunk in file order gets the whole run of (stored-bit) gates
+void mmap_statevector::run_pass(const std::vector<gate_op> &run) {
+    if (run.empty()) {
+        return;
+    }
+    profile::scope timer{profile::simulation};
+    const chunk_program program{run, chunk_qubits};
+    const std::size_t chunk = std::size_t{1} << chunk_qubits;
+    for (std::size_t base = 0; base < size; base += chunk) {
+        program.apply(amplitudes + base, base);
+    }
+    gate_passes++;
+    profile::count_work(run.size(), 2 * size * sizeof(std::complex<double>), 0);
+}
+
+void mmap_statevector::apply_gates(const std::vector<gate_op> &gates) {
+    std::vector<gate_op> run;
+    for (std::size_t g = 0; g < gates.size(); g++) {
+        const gate_op& op = gates[g];
+        if (!layout.is_local(op)) {
+            run_pass(run);
+            run.clear();
+            for (const std::pair<int, int>& exchange : layout.make_local(op, gates, g + 1)) {
+                swap_bits(exchange.first, exchange.second);
+            }
+        }
+        run.push_back(layout.to_stored(op));
+    }
+    run_pass(run);
+}
+
+matrix mmap_statevector::to_matrix() const {
+    return gather_chunks({amplitudes}, size, layout, qubits);
+}
+
+std::map<std::string, std::uint64_t> mmap_statevector::sample_counts(std::uint64_t shots, const std::vector<int> &measured,
+                                                                     std::mt19937_64 &rng) const {
+    return sample_chunks({amplitudes}, size, layout, qubits, shots, measured, rng);
+}
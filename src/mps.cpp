@@ -0,0 +1,481 @@
+#include "mps.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include "profiler.h"
+
+typedef std::complex<double> amplitude;
+
+// Singular values below this fraction of the largest are treated as exact zeros when moving the center
+static const double zero_tolerance = 1e-14;
+
+// One-sided (Hestenes) Jacobi SVD of a column-major m x n matrix with n <= m. On return a holds U * Sigma
+// column by column, v the n x n unitary V (column-major) and sigma the column norms.
+static void jacobi_svd(std::vector<amplitude> &a, int m, int n, std::vector<amplitude> &v, std::vector<double> &sigma) {
+    v.assign(static_cast<std::size_t>(n) * n, amplitude{0, 0});
+    for (int j = 0; j < n; j++) {
+        v[j * n + j] = 1;
+    }
+    for (int sweep = 0; sweep < 60; sweep++) {
+        bool rotated = false;
+        for (int i = 0; i < n - 1; i++) {
+            for (int j = i + 1; j < n; j++) {
+                amplitude* ai = a.data() + static_cast<std::size_t>(i) * m;
+                amplitude* aj = a.data() + static_cast<std::size_t>(j) * m;
+                double alpha = 0, beta = 0;
+                amplitude gamma{0, 0};
+                for (int k = 0; k < m; k++) {
+                    alpha += std::norm(ai[k]);
+                    beta += std::norm(aj[k]);
+                    gamma += std::conj(ai[k]) * aj[k];
+                }
+                const double g = std::abs(gamma);
+                if (g == 0 || g <= 1e-15 * std::sqrt(alpha * beta)) {
+                    continue;
+                }
+                rotated = true;
+                // Phase-align column j so the pair reduces to a real Jacobi rotation
+                const double zeta = (beta - alpha) / (2 * g);
+                const double t = (zeta >= 0 ? 1.0 : -1.0) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+                const double c = 1 / std::sqrt(1 + t * t);
+                const double s = c * t;
+                const amplitude e = std::conj(gamma) / g;
+                for (int k = 0; k < m; k++) {
+                    const amplitude x = ai[k], y = e * aj[k];
+                    ai[k] = c * x - s * y;
+                    aj[k] = s * x + c * y;
+                }
+                amplitude* vi = v.data() + static_cast<std::size_t>(i) * n;
+                amplitude* vj = v.data() + static_cast<std::size_t>(j) * n;
+                for (int k = 0; k < n; k++) {
+                    const amplitude x = vi[k], y = e * vj[k];
+                    vi[k] = c * x - s * y;
+                    vj[k] = s * x + c * y;
+                }
+            }
+        }
+        if (!rotated) {
+            break;
+        }
+    }
+    sigma.resize(n);
+    for (int j = 0; j < n; j++) {
+        double norm = 0;
+        for (int k = 0; k < m; k++) {
+            norm += std::norm(a[static_cast<std::size_t>(j) * m + k]);
+        }
+        sigma[j] = std::sqrt(norm);
+    }
+}
+
+// Thin SVD of a row-major m x n matrix: M = U diag(sigma) Vh with singular values sorted descending.
+// U is m x k row-major, Vh is k x n row-major, k = min(m, n).
+static void svd(const std::vector<amplitude> &mat, int m, int n, std::vector<amplitude> &u, std::vector<double> &sigma,
+                std::vector<amplitude> &vh) {
+    const bool transposed = n > m;  // Work on whichever of M and M^H has fewer columns
+    const int rows = transposed ? n : m;
+    const int cols = transposed ? m : n;
+    std::vector<amplitude> a(static_cast<std::size_t>(rows) * cols);
+    for (int r = 0; r < m; r++) {
+        for (int c = 0; c < n; c++) {
+            const amplitude value = mat[static_cast<std::size_t>(r) * n + c];
+            if (transposed) {
+                a[static_cast<std::size_t>(r) * rows + c] = std::conj(value);  // Column r of M^H
+            } else {
+                a[static_cast<std::size_t>(c) * rows + r] = value;
+            }
+        }
+    }
+    std::vector<amplitude> v;
+    std::vector<double> s;
+    jacobi_svd(a, rows, cols, v, s);
+
+    std::vector<int> order(cols);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int x, int y) { return s[x] > s[y]; });
+
+    // Columns of a / sigma are left vectors of the decomposed matrix, columns of v its right vectors
+    const int k = cols;
+    sigma.resize(k);
+    u.assign(static_cast<std::size_t>(m) * k, amplitude{0, 0});
+    vh.assign(static_cast<std::size_t>(k) * n, amplitude{0, 0});
+    for (int j = 0; j < k; j++) {
+        const int src = order[j];
+        sigma[j] = s[src];
+        const double inv = s[src] > 0 ? 1 / s[src] : 0;
+        for (int r = 0; r < rows; r++) {
+            const amplitude left = a[static_cast<std::size_t>(src) * rows + r] * inv;
+            if (transposed) {
+                vh[static_cast<std::size_t>(j) * n + r] = std::conj(left);  // M = V' S U'^H
+            } else {
+                u[static_cast<std::size_t>(r) * k + j] = left;
+            }
+        }
+        for (int r = 0; r < cols; r++) {
+            const amplitude right = v[static_cast<std::size_t>(src) * cols + r];
+            if (transposed) {
+                u[static_cast<std::size_t>(r) * k + j] = right;
+            } else {
+                vh[static_cast<std::size_t>(j) * n + r] = std::conj(right);
+            }
+        }
+    }
+}
+
+mps_state::mps_state(const std::vector<char> &initial_states, int max_bond, double cutoff)
+    : qubits{static_cast<int>(initial_states.size())}, max_bond{max_bond}, cutoff{cutoff}, center{0}, truncation_error{0} {
+    if (qubits < 1 || max_bond < 1 || cutoff < 0) {
+        throw std::invalid_argument("Invalid MPS parameters.");
+    }
+    sites.resize(qubits);
+    for (int q = 0; q < qubits; q++) {
+        if (initial_states[q] != '0' && initial_states[q] != '1') {
+            throw std::invalid_argument("Initial states must be '0' or '1'.");
+        }
+        sites[q].left = 1;
+        sites[q].right = 1;
+        sites[q].data.assign(2, amplitude{0, 0});
+        sites[q].data[initial_states[q] - '0'] = 1;
+    }
+}
+
+int mps_state::get_qubits() const {
+    return qubits;
+}
+
+int mps_state::get_max_bond() const {
+    int bond = 1;
+    for (const site& s : sites) {
+        bond = std::max(bond, s.right);
+    }
+    return bond;
+}
+
+double mps_state::get_truncation_error() const {
+    return truncation_error;
+}
+
+// Shifts the orthogonality center with exact SVDs (only numerically zero singular values are dropped)
+void mps_state::move_center(int to) {
+    std::vector<amplitude> u, vh;
+    std::vector<double> sigma;
+    while (center < to) {
+        site &a = sites[center];
+        site &b = sites[center + 1];
+        svd(a.data, a.left * 2, a.right, u, sigma, vh);
+        int k = static_cast<int>(sigma.size());
+        while (k > 1 && sigma[k - 1] <= zero_tolerance * sigma[0]) {
+            k--;
+        }
+        const int full = static_cast<int>(sigma.size());
+        a.data.resize(static_cast<std::size_t>(a.left) * 2 * k);
+        for (int r = 0; r < a.left * 2; r++) {
+            for (int j = 0; j < k; j++) {
+                a.data[static_cast<std::size_t>(r) * k + j] = u[static_cast<std::size_t>(r) * full + j];
+            }
+        }
+        // b <- (S Vh) b
+        std::vector<amplitude> next(static_cast<std::size_t>(k) * 2 * b.right, amplitude{0, 0});
+        for (int j = 0; j < k; j++) {
+            for (int m = 0; m < b.left; m++) {
+                const amplitude f = sigma[j] * vh[static_cast<std::size_t>(j) * a.right + m];
+                if (f == amplitude{0, 0}) {
+                    continue;
+                }
+                for (int c = 0; c < 2 * b.right; c++) {
+                    next[static_cast<std::size_t>(j) * 2 * b.right + c] += f * b.data[static_cast<std::size_t>(m) * 2 * b.right + c];
+                }
+            }
+        }
+        a.right = k;
+        b.left = k;
+        b.data.swap(next);
+        center++;
+    }
+    while (center > to) {
+        site &a = sites[center - 1];
+        site &b = sites[center];
+        svd(b.data, b.left, 2 * b.right, u, sigma, vh);
+        int k = static_cast<int>(sigma.size());
+        while (k > 1 && sigma[k - 1] <= zero_tolerance * sigma[0]) {
+            k--;
+        }
+        const int full = static_cast<int>(sigma.size());
+        // a <- a (U S)
+        std::vector<amplitude> prev(static_cast<std::size_t>(a.left) * 2 * k, amplitude{0, 0});
+        for (int r = 0; r < a.left * 2; r++) {
+            for (int m = 0; m < a.right; m++) {
+                const amplitude f = a.data[static_cast<std::size_t>(r) * a.right + m];
+                if (f == amplitude{0, 0}) {
+                    continue;
+                }
+                for (int j = 0; j < k; j++) {
+                    prev[static_cast<std::size_t>(r) * k + j] += f * u[static_cast<std::size_t>(m) * full + j] * sigma[j];
+                }
+            }
+        }
+        b.data.assign(vh.begin(), vh.begin() + static_cast<std::size_t>(k) * 2 * b.right);
+        a.right = k;
+        b.left = k;
+        a.data.swap(prev);
+        center--;
+    }
+}
+
+// Contracts sites q and q+1, applies the gate, and splits them again keeping the largest singular values
+void mps_state::apply_two_site(int q, const amplitude (&g)[4][4]) {
+    move_center(q);
+    site &a = sites[q];
+    site &b = sites[q + 1];
+    const int l = a.left, r = b.right, mid = a.right;
+
+    // theta[(l, s1), (s2, r)] as a row-major (2l x 2r) matrix
+    std::vector<amplitude> theta(static_cast<std::size_t>(4) * l * r, amplitude{0, 0});
+    for (int i = 0; i < l; i++) {
+        for (int s1 = 0; s1 < 2; s1++) {
+            for (int m = 0; m < mid; m++) {
+                const amplitude f = a.data[(static_cast<std::size_t>(i) * 2 + s1) * mid + m];
+                if (f == amplitude{0, 0}) {
+                    continue;
+                }
+                for (int s2 = 0; s2 < 2; s2++) {
+                    const amplitude* src = b.data.data() + (static_cast<std::size_t>(m) * 2 + s2) * r;
+                    amplitude* dst = theta.data() + (static_cast<std::size_t>(i) * 2 + s1) * 2 * r + static_cast<std::size_t>(s2) * r;
+                    for (int j = 0; j < r; j++) {
+                        dst[j] += f * src[j];
+                    }
+                }
+            }
+        }
+    }
+    std::vector<amplitude> gated(theta.size(), amplitude{0, 0});
+    for (int i = 0; i < l; i++) {
+        for (int out = 0; out < 4; out++) {
+            amplitude* dst = gated.data() + (static_cast<std::size_t>(i) * 2 + (out & 1)) * 2 * r + static_cast<std::size_t>(out >> 1) * r;
+            for (int in = 0; in < 4; in++) {
+                if (g[out][in] == amplitude{0, 0}) {
+                    continue;
+                }
+                const amplitude* src = theta.data() + (static_cast<std::size_t>(i) * 2 + (in & 1)) * 2 * r + static_cast<std::size_t>(in >> 1) * r;
+                for (int j = 0; j < r; j++) {
+                    dst[j] += g[out][in] * src[j];
+                }
+            }
+        }
+    }
+
+    std::vector<amplitude> u, vh;
+    std::vector<double> sigma;
+    svd(gated, 2 * l, 2 * r, u, sigma, vh);
+    const int full = static_cast<int>(sigma.size());
+    double total = 0;
+    for (double s : sigma) {
+        total += s * s;
+    }
+    int k = std::min(full, max_bond);
+    while (k > 1 && sigma[k - 1] <= std::max(cutoff, zero_tolerance) * sigma[0]) {
+        k--;
+    }
+    double kept = 0;
+    for (int j = 0; j < k; j++) {
+        kept += sigma[j] * sigma[j];
+    }
+    double discarded = 0;
+    for (int j = k; j < full; j++) {
+        if (sigma[j] > zero_tolerance * sigma[0]) {
+            discarded += sigma[j] * sigma[j];
+        }
+    }
+    if (total > 0) {
+        truncation_error += discarded / total;
+    }
+    const double scale = kept > 0 ? std::sqrt(total / kept) : 1;  // Keep the norm after truncation
+
+    a.data.resize(static_cast<std::size_t>(l) * 2 * k);
+    for (int row = 0; row < 2 * l; row++) {
+        for (int j = 0; j < k; j++) {
+            a.data[static_cast<std::size_t>(row) * k + j] = u[static_cast<std::size_t>(row) * full + j];
+        }
+    }
+    b.data.resize(static_cast<std::size_t>(k) * 2 * r);
+    for (int j = 0; j < k; j++) {
+        for (int c = 0; c < 2 * r; c++) {
+            b.data[static_cast<std::size_t>(j) * 2 * r + c] = sigma[j] * scale * vh[static_cast<std::size_t>(j) * 2 * r + c];
+        }
+    }
+    a.right = k;
+    b.left = k;
+    center = q + 1;
+}
+
+void mps_state::swap_sites(int q) {
+    static const amplitude swap_gate[4][4] = {{1, 0, 0, 0}, {0, 0, 1, 0}, {0, 1, 0, 0}, {0, 0, 0, 1}};
+    apply_two_site(q, swap_gate);
+}
+
+// Brings qubit b next to qubit a with swaps, applies the gate and swaps back
+void mps_state::apply_pair(int a, int b, const amplitude (&g)[4][4]) {
+    if (a < 0 || a >= qubits || b < 0 || b >= qubits || a == b) {
+        throw std::out_of_range("Invalid control/target qubits.");
+    }
+    amplitude h[4][4];
+    const bool flip = a > b;  // Sites are ordered by qubit, so reorder the gate index bits when a is the upper one
+    for (int out = 0; out < 4; out++) {
+        for (int in = 0; in < 4; in++) {
+            const int o = flip ? ((out & 1) << 1) | (out >> 1) : out;
+            const int i = flip ? ((in & 1) << 1) | (in >> 1) : in;
+            h[o][i] = g[out][in];
+        }
+    }
+    const int low = std::min(a, b);
+    const int high = std::max(a, b);
+    for (int p = high - 1; p > low; p--) {
+        swap_sites(p);
+    }
+    apply_two_site(low, h);
+    for (int p = low + 1; p < high; p++) {
+        swap_sites(p);
+    }
+}
+
+// Single-qubit gates act on the physical index only, so the canonical form is preserved
+void mps_state::apply_single(int qubit, const matrix &gate) {
+    if (qubit < 0 || qubit >= qubits) {
+        throw std::out_of_range("Qubit index out of range.");
+    }
+    site &s = sites[qubit];
+    const amplitude u00 = gate.at(0, 0), u01 = gate.at(0, 1), u10 = gate.at(1, 0), u11 = gate.at(1, 1);
+    for (int l = 0; l < s.left; l++) {
+        amplitude* zero = s.data.data() + static_cast<std::size_t>(l) * 2 * s.right;
+        amplitude* one = zero + s.right;
+        for (int r = 0; r < s.right; r++) {
+            const amplitude x = zero[r], y = one[r];
+            zero[r] = u00 * x + u01 * y;
+            one[r] = u10 * x + u11 * y;
+        }
+    }
+}
+
+void mps_state::apply_controlled(int control, int target, const matrix &gate) {
+    amplitude g[4][4] = {};
+    g[0][0] = 1;  // Index bit 0 = control, bit 1 = target
+    g[2][2] = 1;
+    g[1][1] = gate.at(0, 0);
+    g[1][3] = gate.at(0, 1);
+    g[3][1] = gate.at(1, 0);
+    g[3][3] = gate.at(1, 1);
+    apply_pair(control, target, g);
+}
+
+void mps_state::apply_gates(const std::vector<gate_op> &gates) {
+    for (const gate_op& op : gates) {
+        if (op.kind == gate_op::single || (op.kind == gate_op::dense && op.qubits.size() == 1)) {
+            apply_single(op.qubits[0], *op.m);
+        } else if (op.kind == gate_op::controlled) {
+            apply_controlled(op.qubits[0], op.qubits[1], *op.m);
+        } else if (op.qubits.size() == 2) {
+            amplitude g[4][4];
+            for (int out = 0; out < 4; out++) {
+                for (int in = 0; in < 4; in++) {
+                    g[out][in] = op.m->at(out, in);
+                }
+            }
+            apply_pair(op.qubits[0], op.qubits[1], g);
+        } else {
+            throw std::invalid_argument("MPS backend supports gates on at most two qubits.");
+        }
+        profile::count_work(1, 0, 0);
+    }
+}
+
+// Contracts the chain from qubit 0 upwards; entry (index, bond) of the partial state grows to (2^n, 1)
+matrix mps_state::to_matrix() const {
+    std::vector<amplitude> partial(1, amplitude{1, 0});
+    std::size_t prefix = 1;
+    int bond = 1;
+    for (int q = 0; q < qubits; q++) {
+        const site &s = sites[q];
+        std::vector<amplitude> next(prefix * 2 * s.right, amplitude{0, 0});
+        for (std::size_t idx = 0; idx < prefix; idx++) {
+            for (int l = 0; l < bond; l++) {
+                const amplitude f = partial[idx * bond + l];
+                if (f == amplitude{0, 0}) {
+                    continue;
+                }
+                for (int bit = 0; bit < 2; bit++) {
+                    const amplitude* src = s.data.data() + (static_cast<std::size_t>(l) * 2 + bit) * s.right;
+                    amplitude* dst = next.data() + (idx + bit * prefix) * s.right;
+                    for (int r = 0; r < s.right; r++) {
+                        dst[r] += f * src[r];
+                    }
+                }
+            }
+        }
+        partial.swap(next);
+        prefix *= 2;
+        bond = s.right;
+    }
+    matrix output{static_cast<int>(prefix), 1};
+    for (std::size_t i = 0; i < prefix; i++) {
+        // Round off SVD noise so exactly-zero amplitudes print as zero
+        output.at(static_cast<int>(i), 0) = std::abs(partial[i]) < 1e-12 ? amplitude{0, 0} : partial[i];
+    }
+    return output;
+}
+
+// With the center on qubit 0 every other site is right-orthonormal, so each qubit can be sampled from its
+// conditional distribution given the bits already drawn: O(n * bond^2) per shot
+std::map<std::string, std::uint64_t> mps_state::sample_counts(std::uint64_t shots, const std::vector<int> &measured,
+                                                              std::mt19937_64 &rng) const {
+    std::vector<int> targets = measured;
+    if (targets.empty()) {
+        for (int q = 0; q < qubits; q++) {
+            targets.push_back(q);
+        }
+    }
+    std::sort(targets.begin(), targets.end());
+    if (std::adjacent_find(targets.begin(), targets.end()) != targets.end() || targets.front() < 0 || targets.back() >= qubits) {
+        throw std::out_of_range("Measured qubits must be distinct and within the register.");
+    }
+    mps_state canonical = *this;
+    canonical.move_center(0);
+
+    std::uniform_real_distribution<double> uniform{0.0, 1.0};
+    std::map<std::string, std::uint64_t> counts;
+    std::vector<int> bits(qubits);
+    std::string key(targets.size(), '0');
+    std::vector<amplitude> v, w[2];
+    for (std::uint64_t shot = 0; shot < shots; shot++) {
+        v.assign(1, amplitude{1, 0});
+        for (int q = 0; q < qubits; q++) {
+            const site &s = canonical.sites[q];
+            double p[2];
+            for (int bit = 0; bit < 2; bit++) {
+                w[bit].assign(s.right, amplitude{0, 0});
+                for (int l = 0; l < s.left; l++) {
+                    const amplitude* src = s.data.data() + (static_cast<std::size_t>(l) * 2 + bit) * s.right;
+                    for (int r = 0; r < s.right; r++) {
+                        w[bit][r] += v[l] * src[r];
+                    }
+                }
+                p[bit] = 0;
+                for (const amplitude& x : w[bit]) {
+                    p[bit] += std::norm(x);
+                }
+            }
+            const int bit = uniform(rng) * (p[0] + p[1]) < p[0] ? 0 : 1;
+            const double norm = std::sqrt(p[bit]);
+            v.swap(w[bit]);
+            for (amplitude& x : v) {
+                x /= norm;
+            }
+            bits[q] = bit;
+        }
+        for (std::size_t j = 0; j < targets.size(); j++) {
+            key[targets.size() - 1 - j] = bits[targets[j]] ? '1' : '0';
+        }
+        counts[key]++;
+    }
+    return counts;
+}
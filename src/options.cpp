@@ -0,0 +1,258 @@
+#include "options.h"
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include "gate_op.h"
+#include "mmap_statevector.h"
+#include "sharded_statevector.h"
+
+// Returns the value following a flag, or throws if it is missing
+static std::string next_value(int argc, char* argv[], int &i) {
+    if (i + 1 >= argc) {
+        throw std::invalid_argument(std::string("Missing value for ") + argv[i]);
+    }
+    return argv[++i];
+}
+
+// Parses a strictly positive integer option value
+static int parse_positive(const std::string &value, const std::string &flag) {
+    std::size_t used = 0;
+    int result = 0;
+    try {
+        result = std::stoi(value, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used != value.size() || result < 1) {
+        throw std::invalid_argument(flag + " requires a positive integer.");
+    }
+    return result;
+}
+
+// Parses a comma-separated list of qubit indices, e.g. "0,2,3"
+static std::vector<int> parse_qubit_list(const std::string &value, const std::string &flag) {
+    std::vector<int> qubits;
+    std::size_t start = 0;
+    while (start <= value.size()) {
+        std::size_t comma = value.find(',', start);
+        if (comma == std::string::npos) {
+            comma = value.size();
+        }
+        std::string item = value.substr(start, comma - start);
+        qubits.push_back(item == "0" ? 0 : parse_positive(item, flag));
+        start = comma + 1;
+    }
+    return qubits;
+}
+
+// Parses a non-negative real option value
+static double parse_non_negative(const std::string &value, const std::string &flag) {
+    std::size_t used = 0;
+    double result = -1;
+    try {
+        result = std::stod(value, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used != value.size() || !(result >= 0)) {
+        throw std::invalid_argument(flag + " requires a non-negative number.");
+    }
+    return result;
+}
+
+backend_kind resolve_backend(const sim_options &options, int qubits, bool clifford) {
+    if (options.backend == "mps") {
+        return backend_kind::mps;
+    }
+    if (options.backend == "mmap") {
+        return backend_kind::mmap;
+    }
+    if (options.backend == "sharded") {
+        return backend_kind::sharded;
+    }
+    if (options.backend == "stabilizer" && clifford) {
+        return backend_kind::stabilizer;
+    }
+    if (!options.checkpoint_path.empty() || !options.resume_path.empty() || !options.initial_state_path.empty()) {
+        return backend_kind::statevector;  // Saved states are plain amplitude vectors
+    }
+    if (options.backend == "auto") {
+        if (clifford && qubits > stabilizer_auto_qubits) {
+            return backend_kind::stabilizer;
+        }
+        if (qubits > max_statevector_qubits) {
+            return backend_kind::mps;
+        }
+    }
+    return backend_kind::statevector;
+}
+
+int max_backend_qubits(const sim_options &options) {
+    const bool saved_state = !options.checkpoint_path.empty() || !options.resume_path.empty()
+                             || !options.initial_state_path.empty();
+    if (options.all_inputs) {
+        return max_all_inputs_qubits;
+    }
+    if (saved_state || options.backend == "statevector") {
+        return max_statevector_qubits;
+    }
+    if (options.backend == "mmap") {
+        return max_mmap_qubits;
+    }
+    if (options.backend == "sharded") {
+        return max_sharded_qubits;
+    }
+    return std::numeric_limits<int>::max();  // The tableau and the MPS grow with n rather than 2^n
+}
+
+sim_options parse_options(int argc, char* argv[]) {
+    sim_options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--layout") {
+            std::string layout = next_value(argc, argv, i);
+            if (layout != "interleaved" && layout != "split") {
+                throw std::invalid_argument("Layout must be 'interleaved' or 'split'.");
+            }
+            options.split_layout = (layout == "split");
+        } else if (arg == "--precision") {
+            std::string precision = next_value(argc, argv, i);
+            if (precision != "single" && precision != "double") {
+                throw std::invalid_argument("Precision must be 'single' or 'double'.");
+            }
+            options.single_precision = (precision == "single");
+        } else if (arg == "--isa") {
+            options.isa = next_value(argc, argv, i);
+            if (options.isa != "auto" && options.isa != "scalar" && options.isa != "avx2" && options.isa != "avx512") {
+                throw std::invalid_argument("ISA must be one of: auto, scalar, avx2, avx512.");
+            }
+        } else if (arg == "--backend") {
+            options.backend = next_value(argc, argv, i);
+            if (options.backend != "auto" && options.backend != "statevector" && options.backend != "stabilizer"
+                && options.backend != "mps" && options.backend != "mmap" && options.backend != "sharded") {
+                throw std::invalid_argument("Backend must be one of: auto, statevector, stabilizer, mps, mmap, sharded.");
+            }
+        } else if (arg == "--max-bond") {
+            options.max_bond = parse_positive(next_value(argc, argv, i), "--max-bond");
+        } else if (arg == "--mps-cutoff") {
+            options.mps_cutoff = parse_non_negative(next_value(argc, argv, i), "--mps-cutoff");
+        } else if (arg == "--mmap-dir") {
+            options.mmap_dir = next_value(argc, argv, i);
+        } else if (arg == "--chunk-qubits") {
+            options.chunk_qubits = parse_positive(next_value(argc, argv, i), "--chunk-qubits");
+        } else if (arg == "--shards") {
+            options.shards = parse_positive(next_value(argc, argv, i), "--shards");
+        } else if (arg == "--threads") {
+            options.threads = parse_positive(next_value(argc, argv, i), "--threads");
+        } else if (arg == "--fuse") {
+            std::string value = next_value(argc, argv, i);
+            options.fuse = (value == "0") ? 0 : parse_positive(value, "--fuse");
+            if (options.fuse > max_dense_qubits) {
+                throw std::invalid_argument("--fuse must be at most " + std::to_string(max_dense_qubits) + ".");
+            }
+        } else if (arg == "--schedule") {
+            std::string schedule = next_value(argc, argv, i);
+            if (schedule != "gates" && schedule != "layers") {
+                throw std::invalid_argument("Schedule must be 'gates' or 'layers'.");
+            }
+            options.layered = (schedule == "layers");
+        } else if (arg == "--all-inputs") {
+            options.all_inputs = true;
+        } else if (arg == "--shots") {
+            options.shots = parse_positive(next_value(argc, argv, i), "--shots");
+        } else if (arg == "--measure") {
+            options.measured = parse_qubit_list(next_value(argc, argv, i), "--measure");
+        } else if (arg == "--seed") {
+            std::string value = next_value(argc, argv, i);
+            options.seed = (value == "0") ? 0 : parse_positive(value, "--seed");
+            options.fixed_seed = true;
+        } else if (arg == "--epsilon") {
+            options.output.epsilon = parse_non_negative(next_value(argc, argv, i), "--epsilon");
+        } else if (arg == "--top") {
+            options.output.top = parse_positive(next_value(argc, argv, i), "--top");
+        } else if (arg == "--probabilities") {
+            options.output.probabilities = true;
+        } else if (arg == "--batch") {
+            options.batch_file = next_value(argc, argv, i);
+        } else if (arg == "--sweep") {
+            options.sweep_file = next_value(argc, argv, i);
+        } else if (arg == "--checkpoint") {
+            options.checkpoint_path = next_value(argc, argv, i);
+        } else if (arg == "--checkpoint-every") {
+            options.checkpoint_every = parse_positive(next_value(argc, argv, i), "--checkpoint-every");
+        } else if (arg == "--resume") {
+            options.resume_path = next_value(argc, argv, i);
+        } else if (arg == "--initial-state") {
+            options.initial_state_path = next_value(argc, argv, i);
+        } else if (arg == "--alloc-stats") {
+            options.alloc_stats = true;
+        } else if (arg == "--profile") {
+            options.profile_file = next_value(argc, argv, i);
+        } else {
+            throw std::invalid_argument("Unknown option: " + arg);
+        }
+    }
+    if (options.single_precision && (options.split_layout || options.all_inputs)) {
+        throw std::invalid_argument("--precision single is only supported by the interleaved single-input statevector.");
+    }
+    if ((options.single_precision || options.split_layout) && options.backend != "auto" && options.backend != "statevector") {
+        throw std::invalid_argument("--precision and --layout only apply to the statevector backend.");
+    }
+    const bool saved_state = !options.checkpoint_path.empty() || !options.resume_path.empty()
+                             || !options.initial_state_path.empty();
+    if (saved_state && (options.split_layout || options.all_inputs
+                        || (options.backend != "auto" && options.backend != "statevector"))) {
+        throw std::invalid_argument("Checkpoints are only supported by the interleaved single-input statevector.");
+    }
+    if (!options.sweep_file.empty()) {
+        if (options.batch_file.empty()) {
+            throw std::invalid_argument("--sweep requires --batch.");
+        }
+        if (options.split_layout || options.single_precision || options.all_inputs || !options.checkpoint_path.empty()
+            || !options.resume_path.empty() || (options.backend != "auto" && options.backend != "statevector")) {
+            throw std::invalid_argument("--sweep is only supported by the interleaved double precision statevector.");
+        }
+    }
+    if (options.layered && (options.split_layout || options.all_inputs || saved_state || !options.sweep_file.empty()
+                            || (options.backend != "auto" && options.backend != "statevector"))) {
+        throw std::invalid_argument("--schedule layers is only supported by the interleaved single-input statevector.");
+    }
+    if (options.checkpoint_every > 0 && options.checkpoint_path.empty()) {
+        throw std::invalid_argument("--checkpoint-every requires --checkpoint.");
+    }
+    if (!options.resume_path.empty() && !options.initial_state_path.empty()) {
+        throw std::invalid_argument("--resume already restores the state; drop --initial-state.");
+    }
+    return options;
+}
+
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [options]" << std::endl
+              << "  --layout interleaved|split   Statevector storage layout (default: interleaved)" << std::endl
+              << "  --precision single|double    Amplitude precision of the interleaved statevector (default: double)" << std::endl
+              << "  --isa auto|scalar|avx2|avx512  SIMD kernels for the split layout (default: auto)" << std::endl
+              << "  --backend auto|statevector|stabilizer|mps|mmap|sharded  Simulation backend (default: auto)" << std::endl
+              << "  --max-bond N                 MPS bond dimension limit (default: 64)" << std::endl
+              << "  --mps-cutoff X               MPS relative singular value cutoff (default: 1e-12)" << std::endl
+              << "  --mmap-dir DIR               Directory for the out-of-core statevector file (default: $TMPDIR or /tmp)" << std::endl
+              << "  --chunk-qubits N             Out-of-core chunk of 2^N amplitudes per streaming pass (default: 20)" << std::endl
+              << "  --shards N                   Worker processes of the sharded backend, a power of two (default: 4)" << std::endl
+              << "  --threads N                  Worker threads for gate application (default: 1)" << std::endl
+              << "  --fuse K                     Fuse neighbouring gates into blocks of up to K qubits (0 = off, default: 1)" << std::endl
+              << "  --schedule gates|layers      Apply gates one at a time or one circuit layer per pass (default: gates)" << std::endl
+              << "  --all-inputs                 Simulate every computational basis input as one batch (up to 10 qubits)" << std::endl
+              << "  --shots N                    Sample N measurements of the final state and print a histogram" << std::endl
+              << "  --measure Q,Q,...            Qubits to sample with --shots (default: all)" << std::endl
+              << "  --seed S                     Seed for --shots sampling (default: random)" << std::endl
+              << "  --epsilon E                  Omit output amplitudes of magnitude at most E (default: 0)" << std::endl
+              << "  --top K                      Print only the K most probable output terms" << std::endl
+              << "  --probabilities              Print output probabilities instead of amplitudes" << std::endl
+              << "  --batch FILE                 Run every circuit in FILE without prompts ('-' reads stdin)" << std::endl
+              << "  --sweep FILE                 Run each parameterised circuit at every point in FILE (with --batch)" << std::endl
+              << "  --checkpoint FILE            Write the final statevector to FILE in binary form" << std::endl
+              << "  --checkpoint-every N         Also checkpoint after every N gates" << std::endl
+              << "  --resume FILE                Continue a circuit from a checkpoint" << std::endl
+              << "  --initial-state FILE         Use the amplitudes saved in FILE as the input state" << std::endl
+              << "  --alloc-stats                Print matrix heap allocations and arena reuses to stderr on exit" << std::endl
+              << "  --profile FILE               Write per-phase timings and work counters as JSON ('-' = stderr)" << std::endl;
+}
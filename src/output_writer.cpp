@@ -0,0 +1,47 @@
+#include "output_writer.h"
+#include <cstdio>
+#include <cstring>
+
+output_writer::output_writer(std::ostream &os, std::size_t capacity) : os(os), buffer(capacity < 64 ? 64 : capacity) {}
+
+output_writer::~output_writer() {
+    flush();
+}
+
+void output_writer::put(char c) {
+    if (used == buffer.size()) {
+        flush();
+    }
+    buffer[used++] = c;
+}
+
+void output_writer::put(const char* text) {
+    const std::size_t length = std::strlen(text);
+    if (used + length > buffer.size()) {
+        flush();
+        if (length > buffer.size()) {
+            os.write(text, length);
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + used, text, length);
+    used += length;
+}
+
+void output_writer::put(const std::string &text) {
+    put(text.c_str());
+}
+
+void output_writer::put_number(double value, int precision) {
+    if (buffer.size() - used < 32) {
+        flush();
+    }
+    used += std::snprintf(buffer.data() + used, 32, "%.*g", precision, value);
+}
+
+void output_writer::flush() {
+    if (used > 0) {
+        os.write(buffer.data(), used);
+        used = 0;
+    }
+}
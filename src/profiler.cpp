@@ -0,0 +1,86 @@
+#include "profiler.h"
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
+#include "matrix.h"
+
+namespace profile
+{
+
+typedef std::chrono::steady_clock clock;
+
+bool active = false;
+counters totals = {0, 0, 0};
+
+static phase current = none;
+static clock::time_point start_time;
+static clock::time_point last_switch;
+static double phase_seconds[phase_count] = {};
+static matrix_alloc_stats start_allocations = {0, 0, 0};
+
+static const char* phase_name(int p) {
+    switch (p) {
+        case input: return "input";
+        case gate_construction: return "gate_construction";
+        case scheduling: return "scheduling";
+        case simulation: return "simulation";
+        case sampling: return "sampling";
+        case output: return "output";
+        default: return "unattributed";
+    }
+}
+
+// Charges the time since the last phase change to the current phase
+static void switch_to(phase next) {
+    clock::time_point now = clock::now();
+    phase_seconds[current] += std::chrono::duration<double>(now - last_switch).count();
+    last_switch = now;
+    current = next;
+}
+
+void start() {
+    active = true;
+    totals = counters{0, 0, 0};
+    std::fill(phase_seconds, phase_seconds + phase_count, 0.0);
+    current = none;
+    start_time = clock::now();
+    last_switch = start_time;
+    start_allocations = get_matrix_alloc_stats();
+}
+
+scope::scope(phase p) : previous{none}, running{active} {
+    if (running) {
+        previous = current;
+        switch_to(p);
+    }
+}
+
+scope::~scope() {
+    if (running) {
+        switch_to(previous);
+    }
+}
+
+void write_report(std::ostream &os) {
+    switch_to(current);
+    const double wall = std::chrono::duration<double>(last_switch - start_time).count();
+    const matrix_alloc_stats allocations = get_matrix_alloc_stats();
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << std::setprecision(9);
+    os << "{\n  \"wall_seconds\": " << wall << ",\n  \"phases\": {";
+    for (int p = input; p < phase_count; p++) {
+        os << "\"" << phase_name(p) << "\": " << phase_seconds[p] << ", ";
+    }
+    os << "\"" << phase_name(none) << "\": " << phase_seconds[none] << "},\n";
+    os << "  \"counters\": {\"gates_applied\": " << totals.gates_applied
+       << ", \"bytes_touched\": " << totals.bytes_touched
+       << ", \"flops\": " << totals.flops
+       << ", \"matrix_allocations\": " << allocations.allocations - start_allocations.allocations
+       << ", \"matrix_bytes_allocated\": " << allocations.bytes - start_allocations.bytes
+       << ", \"arena_reuses\": " << allocations.reuses - start_allocations.reuses << "}\n}" << std::endl;
+    os.flags(flags);
+    os.precision(precision);
+}
+
+}
@@ -0,0 +1,101 @@
+#include "sampler.h"
+#include <algorithm>
+#include <stdexcept>
+
+sampler::sampler(const matrix &state, const std::vector<int> &qubits) {
+    const std::size_t size = static_cast<std::size_t>(state.get_rows());
+    int n = 0;
+    while ((std::size_t{1} << n) < size) {
+        n++;
+    }
+    if (state.get_cols() != 1 || (std::size_t{1} << n) != size) {
+        throw std::invalid_argument("Sampling needs a statevector of size 2^n.");
+    }
+    measured = qubits;
+    if (measured.empty()) {
+        for (int q = 0; q < n; q++) {
+            measured.push_back(q);
+        }
+    }
+    std::sort(measured.begin(), measured.end());
+    if (std::adjacent_find(measured.begin(), measured.end()) != measured.end()
+        || measured.front() < 0 || measured.back() >= n) {
+        throw std::out_of_range("Measured qubits must be distinct and within the register.");
+    }
+
+    // Sum |amplitude|^2 into one bin per outcome of the measured qubits
+    const int k = static_cast<int>(measured.size());
+    std::vector<double> probabilities(std::size_t{1} << k, 0.0);
+    const std::complex<double>* amplitude = state.data();
+    if (k == n) {
+        for (std::size_t i = 0; i < size; i++) {
+            probabilities[i] = std::norm(amplitude[i]);
+        }
+    } else {
+        for (std::size_t i = 0; i < size; i++) {
+            std::size_t bin = 0;
+            for (int j = 0; j < k; j++) {
+                bin |= ((i >> measured[j]) & 1) << j;
+            }
+            probabilities[bin] += std::norm(amplitude[i]);
+        }
+    }
+    build_alias(probabilities);
+}
+
+// Vose's alias method: O(bins) setup, then each sample is one uniform draw and one comparison
+void sampler::build_alias(std::vector<double> &probabilities) {
+    const std::size_t bins = probabilities.size();
+    double total = 0;
+    for (double p : probabilities) {
+        total += p;
+    }
+    if (!(total > 0)) {
+        throw std::invalid_argument("Cannot sample from a zero statevector.");
+    }
+    threshold.assign(bins, 1.0);
+    alias.resize(bins);
+    std::vector<std::uint32_t> small, large;
+    for (std::size_t b = 0; b < bins; b++) {
+        alias[b] = static_cast<std::uint32_t>(b);
+        probabilities[b] *= bins / total;
+        (probabilities[b] < 1.0 ? small : large).push_back(static_cast<std::uint32_t>(b));
+    }
+    while (!small.empty() && !large.empty()) {
+        std::uint32_t s = small.back();
+        std::uint32_t l = large.back();
+        small.pop_back();
+        threshold[s] = probabilities[s];
+        alias[s] = l;
+        probabilities[l] -= 1.0 - probabilities[s];
+        if (probabilities[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // Whatever is left is 1 up to rounding and keeps its own bin (threshold already 1)
+}
+
+const std::vector<int>& sampler::get_measured() const {
+    return measured;
+}
+
+std::size_t sampler::get_outcomes() const {
+    return threshold.size();
+}
+
+std::uint32_t sampler::sample(std::mt19937_64 &rng) const {
+    // One 64-bit draw: high bits pick the bin, low 32 bits give the uniform for the threshold test
+    const std::uint64_t r = rng();
+    const std::size_t bin = static_cast<std::size_t>((r >> 32) * threshold.size() >> 32);
+    const double u = static_cast<double>(r & 0xffffffffu) * (1.0 / 4294967296.0);
+    return u < threshold[bin] ? static_cast<std::uint32_t>(bin) : alias[bin];
+}
+
+std::vector<std::uint64_t> sampler::sample_counts(std::uint64_t shots, std::mt19937_64 &rng) const {
+    std::vector<std::uint64_t> counts(threshold.size(), 0);
+    for (std::uint64_t s = 0; s < shots; s++) {
+        counts[sample(rng)]++;
+    }
+    return counts;
+}
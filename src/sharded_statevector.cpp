@@ -0,0 +1,282 @@
+#include "sharded_statevector.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "thread_pool.h"
+#include "profiler.h"
+
+static std::string system_error(const std::string &what) {
+    return what + ": " + std::strerror(errno);
+}
+
+// Maps a zero-filled shared memory segment; the name is unlinked at once, forked workers inherit the mapping
+static std::complex<double>* map_shard(std::size_t bytes) {
+    static unsigned counter = 0;
+    const std::string name = "/qc-shard-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error(system_error("Cannot create shared memory segment " + name));
+    }
+    shm_unlink(name.c_str());
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        close(fd);
+        throw std::runtime_error(system_error("Cannot size shared memory segment"));
+    }
+    void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error(system_error("Cannot map shared memory segment"));
+    }
+    return static_cast<std::complex<double>*>(mapped);
+}
+
+sharded_statevector::sharded_statevector(const std::vector<char> &initial_states, int shards, int threads_per_shard)
+    : qubits{static_cast<int>(initial_states.size())}, shard_bits{0}, threads_per_shard{threads_per_shard}, layout{0, 0} {
+    if (shards < 2 || shards > max_shards || (shards & (shards - 1)) != 0) {
+        throw std::invalid_argument("Shard count must be a power of two from 2 to " + std::to_string(max_shards) + ".");
+    }
+    while ((1 << shard_bits) < shards) {
+        shard_bits++;
+    }
+    local_qubits = qubits - shard_bits;
+    if (qubits > max_sharded_qubits || local_qubits < 2) {
+        throw std::invalid_argument(std::to_string(shards) + " shards need between " + std::to_string(shard_bits + 2)
+                                    + " and " + std::to_string(max_sharded_qubits) + " qubits.");
+    }
+    const std::size_t start = basis_index(initial_states);
+    shard_size = std::size_t{1} << local_qubits;
+    layout = qubit_layout{qubits, local_qubits};
+    try {
+        for (int k = 0; k < shards; k++) {
+            this->shards.push_back(map_shard(shard_size * sizeof(std::complex<double>)));
+        }
+    } catch (...) {
+        for (std::complex<double>* shard : this->shards) {
+            munmap(shard, shard_size * sizeof(std::complex<double>));
+        }
+        throw;
+    }
+
+    this->shards[start >> local_qubits][start & (shard_size - 1)] = std::complex<double>{1, 0};
+}
+
+sharded_statevector::~sharded_statevector() {
+    for (std::complex<double>* shard : shards) {
+        munmap(shard, shard_size * sizeof(std::complex<double>));
+    }
+}
+
+sharded_statevector::sharded_statevector(sharded_statevector &&other) noexcept
+    : qubits{other.qubits}, shard_bits{other.shard_bits}, local_qubits{other.local_qubits}, shard_size{other.shard_size},
+      threads_per_shard{other.threads_per_shard}, shards{std::move(other.shards)}, layout{std::move(other.layout)},
+      gate_runs{other.gate_runs}, exchanges{other.exchanges} {
+    other.shards.clear();
+}
+
+// Accessors
+int sharded_statevector::get_qubits() const {
+    return qubits;
+}
+
+int sharded_statevector::get_shards() const {
+    return static_cast<int>(shards.size());
+}
+
+std::uint64_t sharded_statevector::get_gate_runs() const {
+    return gate_runs;
+}
+
+std::uint64_t sharded_statevector::get_exchanges() const {
+    return exchanges;
+}
+
+// Plan entry: a gate run applied by every shard, or an exchange of stored bits high (global) and low
+struct shard_step
+{
+    int program;  // Index into the run list, -1 for an exchange
+    int high;
+    int low;
+};
+
+// Pipes between the coordinator and one worker, used only as a barrier
+struct worker_link
+{
+    pid_t pid;
+    int ready;  // Worker -> coordinator
+    int go;     // Coordinator -> worker
+};
+
+// Worker side of a barrier; a vanished coordinator ends the worker
+static void worker_barrier(int ready, int go) {
+    char token = 0;
+    if (write(ready, &token, 1) != 1 || read(go, &token, 1) != 1) {
+        _exit(1);
+    }
+}
+
+// Coordinator side: waits until every worker arrives, then releases them all
+static bool coordinator_barrier(const std::vector<worker_link> &workers) {
+    char token = 0;
+    for (const worker_link& worker : workers) {
+        if (read(worker.ready, &token, 1) != 1) {
+            return false;
+        }
+    }
+    for (const worker_link& worker : workers) {
+        if (write(worker.go, &token, 1) != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void sharded_statevector::apply_gates(const std::vector<gate_op> &gates) {
+    profile::scope timer{profile::simulation};
+    // Plan in the coordinator; the workers inherit it through fork
+    std::vector<chunk_program> programs;
+    std::vector<shard_step> plan;
+    std::vector<gate_op> run;
+    auto close_run = [&]() {
+        if (!run.empty()) {
+            programs.emplace_back(run, local_qubits);
+            plan.push_back(shard_step{static_cast<int>(programs.size()) - 1, 0, 0});
+            run.clear();
+        }
+    };
+    for (std::size_t g = 0; g < gates.size(); g++) {
+        const gate_op& op = gates[g];
+        if (op.kind == gate_op::dense && static_cast<int>(op.qubits.size()) > local_qubits) {
+            throw std::invalid_argument("Dense block is wider than a shard.");
+        }
+        if (!layout.is_local(op)) {
+            close_run();
+            for (const std::pair<int, int>& exchange : layout.make_local(op, gates, g + 1)) {
+                plan.push_back(shard_step{-1, exchange.first, exchange.second});
+            }
+        }
+        run.push_back(layout.to_stored(op));
+    }
+    close_run();
+    if (plan.empty()) {
+        return;
+    }
+
+    std::cout.flush();  // Forked workers must not inherit unflushed output
+    std::fflush(nullptr);
+    std::vector<worker_link> workers;
+    std::string error;
+    for (std::size_t k = 0; k < shards.size() && error.empty(); k++) {
+        int ready[2];
+        int go[2];
+        if (pipe(ready) != 0) {
+            error = system_error("Cannot create worker pipe");
+            break;
+        }
+        if (pipe(go) != 0) {
+            error = system_error("Cannot create worker pipe");
+            close(ready[0]);
+            close(ready[1]);
+            break;
+        }
+        const pid_t pid = fork();
+        if (pid < 0) {
+            error = system_error("Cannot start shard worker");
+            close(ready[0]);
+            close(ready[1]);
+            close(go[0]);
+            close(go[1]);
+            break;
+        }
+        if (pid == 0) {
+            close(ready[0]);
+            close(go[1]);
+            for (const worker_link& earlier : workers) {
+                close(earlier.ready);
+                close(earlier.go);
+            }
+            int status = 0;
+            try {
+                thread_pool::forget_shared();
+                thread_pool::configure_shared(threads_per_shard);
+                const std::size_t base = k << local_qubits;
+                for (const shard_step& step : plan) {
+                    if (step.program >= 0) {
+                        programs[step.program].apply(shards[k], base);
+                        continue;
+                    }
+                    // Partners split the exchanged pairs: the shard without the bit takes the first half
+                    const std::size_t bit = std::size_t{1} << (step.high - local_qubits);
+                    const std::size_t pairs = shard_size >> 1;
+                    worker_barrier(ready[1], go[0]);
+                    if (k & bit) {
+                        swap_between_chunks(shards[k ^ bit], shards[k], step.low, pairs / 2, pairs);
+                    } else {
+                        swap_between_chunks(shards[k], shards[k | bit], step.low, 0, pairs / 2);
+                    }
+                    worker_barrier(ready[1], go[0]);
+                }
+            } catch (...) {
+                status = 1;
+            }
+            _exit(status);
+        }
+        close(ready[1]);
+        close(go[0]);
+        workers.push_back(worker_link{pid, ready[0], go[1]});
+    }
+
+    if (error.empty()) {
+        for (const shard_step& step : plan) {
+            if (step.program < 0 && !(coordinator_barrier(workers) && coordinator_barrier(workers))) {
+                error = "A shard worker stopped unexpectedly.";
+                break;
+            }
+        }
+    }
+    for (const worker_link& worker : workers) {
+        if (!error.empty()) {
+            kill(worker.pid, SIGKILL);
+        }
+        close(worker.ready);
+        close(worker.go);
+    }
+    for (const worker_link& worker : workers) {
+        int status = 0;
+        if (waitpid(worker.pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            if (error.empty()) {
+                error = "A shard worker failed.";
+            }
+        }
+    }
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+
+    const std::uint64_t bytes = 2 * (shard_size << shard_bits) * sizeof(std::complex<double>);
+    for (const shard_step& step : plan) {
+        if (step.program >= 0) {
+            gate_runs++;
+            profile::count_work(programs[step.program].get_gate_count(), bytes, 0);
+        } else {
+            exchanges++;
+            profile::count_work(0, bytes, 0);
+        }
+    }
+}
+
+matrix sharded_statevector::to_matrix() const {
+    return gather_chunks(std::vector<const std::complex<double>*>(shards.begin(), shards.end()), shard_size, layout, qubits);
+}
+
+std::map<std::string, std::uint64_t> sharded_statevector::sample_counts(std::uint64_t shots, const std::vector<int> &measured,
+                                                                        std::mt19937_64 &rng) const {
+    return sample_chunks(std::vector<const std::complex<double>*>(shards.begin(), shards.end()), shard_size, layout, qubits,
+                         shots, measured, rng);
+}
@@ -0,0 +1,216 @@
+#include "simd_kernels.h"
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QC_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace simd
+{
+
+// Scalar update of len amplitude pairs starting at first
+static void update_pairs_scalar(double* re, double* im, std::size_t first, std::size_t stride, std::size_t len, const gate2 &u) {
+    for (std::size_t i = first; i < first + len; i++) {
+        const double ar0 = re[i], ai0 = im[i];
+        const double ar1 = re[i + stride], ai1 = im[i + stride];
+        re[i] = u.re[0] * ar0 - u.im[0] * ai0 + u.re[1] * ar1 - u.im[1] * ai1;
+        im[i] = u.re[0] * ai0 + u.im[0] * ar0 + u.re[1] * ai1 + u.im[1] * ar1;
+        re[i + stride] = u.re[2] * ar0 - u.im[2] * ai0 + u.re[3] * ar1 - u.im[3] * ai1;
+        im[i + stride] = u.re[2] * ai0 + u.im[2] * ar0 + u.re[3] * ai1 + u.im[3] * ar1;
+    }
+}
+
+#ifdef QC_X86_KERNELS
+
+__attribute__((target("avx2,fma")))
+static void update_pairs_avx2(double* re, double* im, std::size_t first, std::size_t stride, std::size_t len, const gate2 &u) {
+    const __m256d u00r = _mm256_set1_pd(u.re[0]), u00i = _mm256_set1_pd(u.im[0]);
+    const __m256d u01r = _mm256_set1_pd(u.re[1]), u01i = _mm256_set1_pd(u.im[1]);
+    const __m256d u10r = _mm256_set1_pd(u.re[2]), u10i = _mm256_set1_pd(u.im[2]);
+    const __m256d u11r = _mm256_set1_pd(u.re[3]), u11i = _mm256_set1_pd(u.im[3]);
+    std::size_t j = 0;
+    for (; j + 4 <= len; j += 4) {
+        double* r0 = re + first + j;
+        double* i0 = im + first + j;
+        double* r1 = r0 + stride;
+        double* i1 = i0 + stride;
+        const __m256d ar0 = _mm256_loadu_pd(r0), ai0 = _mm256_loadu_pd(i0);
+        const __m256d ar1 = _mm256_loadu_pd(r1), ai1 = _mm256_loadu_pd(i1);
+
+        __m256d out_r0 = _mm256_mul_pd(u00r, ar0);
+        out_r0 = _mm256_fnmadd_pd(u00i, ai0, out_r0);
+        out_r0 = _mm256_fmadd_pd(u01r, ar1, out_r0);
+        out_r0 = _mm256_fnmadd_pd(u01i, ai1, out_r0);
+        __m256d out_i0 = _mm256_mul_pd(u00r, ai0);
+        out_i0 = _mm256_fmadd_pd(u00i, ar0, out_i0);
+        out_i0 = _mm256_fmadd_pd(u01r, ai1, out_i0);
+        out_i0 = _mm256_fmadd_pd(u01i, ar1, out_i0);
+        __m256d out_r1 = _mm256_mul_pd(u10r, ar0);
+        out_r1 = _mm256_fnmadd_pd(u10i, ai0, out_r1);
+        out_r1 = _mm256_fmadd_pd(u11r, ar1, out_r1);
+        out_r1 = _mm256_fnmadd_pd(u11i, ai1, out_r1);
+        __m256d out_i1 = _mm256_mul_pd(u10r, ai0);
+        out_i1 = _mm256_fmadd_pd(u10i, ar0, out_i1);
+        out_i1 = _mm256_fmadd_pd(u11r, ai1, out_i1);
+        out_i1 = _mm256_fmadd_pd(u11i, ar1, out_i1);
+
+        _mm256_storeu_pd(r0, out_r0);
+        _mm256_storeu_pd(i0, out_i0);
+        _mm256_storeu_pd(r1, out_r1);
+        _mm256_storeu_pd(i1, out_i1);
+    }
+    update_pairs_scalar(re, im, first + j, stride, len - j, u);
+}
+
+__attribute__((target("avx512f")))
+static void update_pairs_avx512(double* re, double* im, std::size_t first, std::size_t stride, std::size_t len, const gate2 &u) {
+    const __m512d u00r = _mm512_set1_pd(u.re[0]), u00i = _mm512_set1_pd(u.im[0]);
+    const __m512d u01r = _mm512_set1_pd(u.re[1]), u01i = _mm512_set1_pd(u.im[1]);
+    const __m512d u10r = _mm512_set1_pd(u.re[2]), u10i = _mm512_set1_pd(u.im[2]);
+    const __m512d u11r = _mm512_set1_pd(u.re[3]), u11i = _mm512_set1_pd(u.im[3]);
+    std::size_t j = 0;
+    for (; j + 8 <= len; j += 8) {
+        double* r0 = re + first + j;
+        double* i0 = im + first + j;
+        double* r1 = r0 + stride;
+        double* i1 = i0 + stride;
+        const __m512d ar0 = _mm512_loadu_pd(r0), ai0 = _mm512_loadu_pd(i0);
+        const __m512d ar1 = _mm512_loadu_pd(r1), ai1 = _mm512_loadu_pd(i1);
+
+        __m512d out_r0 = _mm512_mul_pd(u00r, ar0);
+        out_r0 = _mm512_fnmadd_pd(u00i, ai0, out_r0);
+        out_r0 = _mm512_fmadd_pd(u01r, ar1, out_r0);
+        out_r0 = _mm512_fnmadd_pd(u01i, ai1, out_r0);
+        __m512d out_i0 = _mm512_mul_pd(u00r, ai0);
+        out_i0 = _mm512_fmadd_pd(u00i, ar0, out_i0);
+        out_i0 = _mm512_fmadd_pd(u01r, ai1, out_i0);
+        out_i0 = _mm512_fmadd_pd(u01i, ar1, out_i0);
+        __m512d out_r1 = _mm512_mul_pd(u10r, ar0);
+        out_r1 = _mm512_fnmadd_pd(u10i, ai0, out_r1);
+        out_r1 = _mm512_fmadd_pd(u11r, ar1, out_r1);
+        out_r1 = _mm512_fnmadd_pd(u11i, ai1, out_r1);
+        __m512d out_i1 = _mm512_mul_pd(u10r, ai0);
+        out_i1 = _mm512_fmadd_pd(u10i, ar0, out_i1);
+        out_i1 = _mm512_fmadd_pd(u11r, ai1, out_i1);
+        out_i1 = _mm512_fmadd_pd(u11i, ar1, out_i1);
+
+        _mm512_storeu_pd(r0, out_r0);
+        _mm512_storeu_pd(i0, out_i0);
+        _mm512_storeu_pd(r1, out_r1);
+        _mm512_storeu_pd(i1, out_i1);
+    }
+    update_pairs_avx2(re, im, first + j, stride, len - j, u);
+}
+
+#endif
+
+typedef void (*pair_kernel)(double*, double*, std::size_t, std::size_t, std::size_t, const gate2&);
+
+static pair_kernel kernel_for(isa target) {
+#ifdef QC_X86_KERNELS
+    if (target == isa::avx512) {
+        return update_pairs_avx512;
+    } else if (target == isa::avx2) {
+        return update_pairs_avx2;
+    }
+#endif
+    return update_pairs_scalar;
+}
+
+// Number of pairs processed per vector iteration
+static std::size_t vector_width(isa target) {
+    return target == isa::avx512 ? 8 : (target == isa::avx2 ? 4 : 1);
+}
+
+static isa current_isa = detect();
+static pair_kernel current_kernel = kernel_for(current_isa);
+
+// Vector kernel when runs are at least one vector wide, scalar otherwise (avoids per-pair calls into wide code)
+static pair_kernel kernel_for_run(std::size_t run) {
+    return run >= vector_width(current_isa) ? current_kernel : update_pairs_scalar;
+}
+
+isa detect() {
+#ifdef QC_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return isa::avx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return isa::avx2;
+    }
+#endif
+    return isa::scalar;
+}
+
+isa active() {
+    return current_isa;
+}
+
+void set_isa(isa target) {
+    isa supported = detect();
+    if (static_cast<int>(target) > static_cast<int>(supported)) {
+        target = supported;
+    }
+    current_isa = target;
+    current_kernel = kernel_for(target);
+}
+
+const char* isa_name(isa target) {
+    switch (target) {
+        case isa::avx512: return "avx512";
+        case isa::avx2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+gate2 make_gate2(const matrix &gate) {
+    gate2 u;
+    for (int k = 0; k < 4; k++) {
+        std::complex<double> value = gate.get_value(k / 2 + 1, k % 2 + 1);
+        u.re[k] = value.real();
+        u.im[k] = value.imag();
+    }
+    return u;
+}
+
+void update_pairs(double* re, double* im, std::size_t first, std::size_t stride, std::size_t len, const gate2 &u) {
+    current_kernel(re, im, first, stride, len, u);
+}
+
+// Returns k with a zero bit inserted at position bit (higher bits shifted up)
+static inline std::size_t insert_zero_bit(std::size_t k, int bit) {
+    std::size_t low_mask = (std::size_t{1} << bit) - 1;
+    return ((k & ~low_mask) << 1) | (k & low_mask);
+}
+
+// Pairs come in runs of 2^qubit contiguous amplitudes
+void apply_single(double* re, double* im, int qubit, std::size_t begin, std::size_t end, const gate2 &u) {
+    const std::size_t stride = std::size_t{1} << qubit;
+    pair_kernel kernel = kernel_for_run(stride);
+    std::size_t k = begin;
+    while (k < end) {
+        const std::size_t len = std::min(end - k, stride - (k & (stride - 1)));
+        kernel(re, im, insert_zero_bit(k, qubit), stride, len, u);
+        k += len;
+    }
+}
+
+// Control-set/target-clear amplitudes come in runs of 2^min(control, target)
+void apply_controlled(double* re, double* im, int control, int target, std::size_t begin, std::size_t end, const gate2 &u) {
+    const int low = std::min(control, target);
+    const int high = std::max(control, target);
+    const std::size_t stride = std::size_t{1} << target;
+    const std::size_t control_bit = std::size_t{1} << control;
+    const std::size_t run = std::size_t{1} << low;
+    pair_kernel kernel = kernel_for_run(run);
+    std::size_t k = begin;
+    while (k < end) {
+        const std::size_t len = std::min(end - k, run - (k & (run - 1)));
+        kernel(re, im, insert_zero_bit(insert_zero_bit(k, low), high) | control_bit, stride, len, u);
+        k += len;
+    }
+}
+
+}
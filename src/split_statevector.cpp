@@ -0,0 +1,293 @@
+#include "split_statevector.h"
+#include <stdexcept>
+#include "thread_pool.h"
+#include "gate_op.h"
+#include <algorithm>
+
+// Constructor from column vector
+split_statevector::split_statevector(const matrix &input) : qubits{0} {
+    if (input.get_cols() != 1 || input.get_rows() < 1) {
+        throw std::invalid_argument("Input must be a column vector.");
+    }
+    while ((1 << qubits) < input.get_rows()) {
+        qubits++;
+    }
+    if ((1 << qubits) != input.get_rows()) {
+        throw std::invalid_argument("Input vector size must be a power of 2.");
+    }
+    real_parts.resize(input.get_rows());
+    imag_parts.resize(input.get_rows());
+    for (int i = 0; i < input.get_rows(); i++) {
+        real_parts[i] = input.at(i, 0).real();
+        imag_parts[i] = input.at(i, 0).imag();
+    }
+}
+
+// Accessors
+int split_statevector::get_qubits() const {
+    return qubits;
+}
+
+std::size_t split_statevector::get_size() const {
+    return real_parts.size();
+}
+
+double* split_statevector::real_data() {
+    return real_parts.data();
+}
+
+double* split_statevector::imag_data() {
+    return imag_parts.data();
+}
+
+// Returns k with a zero bit inserted at position bit (higher bits shifted up)
+static inline std::size_t insert_zero_bit(std::size_t k, int bit) {
+    std::size_t low_mask = (std::size_t{1} << bit) - 1;
+    return ((k & ~low_mask) << 1) | (k & low_mask);
+}
+
+// Multiplies (re, im) by a phase, using sign flips and swaps for unit phases
+static inline void apply_phase_parts(phase_kind kind, std::complex<double> f, double &re, double &im) {
+    std::complex<double> a = apply_phase(kind, f, std::complex<double>{re, im});
+    re = a.real();
+    im = a.imag();
+}
+
+// Multiplies a run of len amplitudes by a phase; the switch sits outside the loop so each case vectorises
+static void apply_phase_run(phase_kind kind, std::complex<double> f, double* re, double* im, std::size_t len) {
+    switch (kind) {
+        case phase_one:
+            break;
+        case phase_minus_one:
+            for (std::size_t j = 0; j < len; j++) {
+                re[j] = -re[j];
+                im[j] = -im[j];
+            }
+            break;
+        case phase_i:  // (re, im) -> (-im, re)
+            for (std::size_t j = 0; j < len; j++) {
+                double r = re[j];
+                re[j] = -im[j];
+                im[j] = r;
+            }
+            break;
+        case phase_minus_i:  // (re, im) -> (im, -re)
+            for (std::size_t j = 0; j < len; j++) {
+                double r = re[j];
+                re[j] = im[j];
+                im[j] = -r;
+            }
+            break;
+        default:
+            for (std::size_t j = 0; j < len; j++) {
+                double r = re[j];
+                re[j] = f.real() * r - f.imag() * im[j];
+                im[j] = f.real() * im[j] + f.imag() * r;
+            }
+            break;
+    }
+}
+
+// Calls update(re, im, first, stride, len) on each run of contiguous amplitude pairs covered by the work items
+template <typename Update>
+static void sweep_pairs(double* re, double* im, std::size_t count, std::size_t stride, std::size_t run,
+                        int low, int high, std::size_t set_bits, Update update) {
+    parallel_sweep(count, [=](std::size_t begin, std::size_t end) {
+        std::size_t k = begin;
+        while (k < end) {
+            const std::size_t len = std::min(end - k, run - (k & (run - 1)));
+            std::size_t first = insert_zero_bit(k, low);
+            if (high >= 0) {
+                first = insert_zero_bit(first, high);
+            }
+            update(re, im, first | set_bits, stride, len);
+            k += len;
+        }
+    });
+}
+
+struct split_diagonal_update
+{
+    std::complex<double> d0, d1;
+    phase_kind k0, k1;
+    void operator()(double* re, double* im, std::size_t first, std::size_t stride, std::size_t len) const {
+        apply_phase_run(k0, d0, re + first, im + first, len);
+        apply_phase_run(k1, d1, re + first + stride, im + first + stride, len);
+    }
+};
+
+struct split_antidiagonal_update
+{
+    std::complex<double> f01, f10;
+    phase_kind k01, k10;
+    void operator()(double* re, double* im, std::size_t first, std::size_t stride, std::size_t len) const {
+        std::swap_ranges(re + first, re + first + len, re + first + stride);
+        std::swap_ranges(im + first, im + first + len, im + first + stride);
+        apply_phase_run(k01, f01, re + first, im + first, len);
+        apply_phase_run(k10, f10, re + first + stride, im + first + stride, len);
+    }
+};
+
+// Runs the diagonal or antidiagonal fast path if the gate allows it, returns false for dense gates
+static bool apply_structured(double* re, double* im, std::size_t count, std::size_t stride, std::size_t run,
+                             int low, int high, std::size_t set_bits, const matrix &gate, gate_structure structure) {
+    const std::complex<double> zero{0, 0};
+    const std::complex<double> u00 = gate.get_value(1, 1);
+    const std::complex<double> u01 = gate.get_value(1, 2);
+    const std::complex<double> u10 = gate.get_value(2, 1);
+    const std::complex<double> u11 = gate.get_value(2, 2);
+    if (structure == gate_structure::diagonal && u01 == zero && u10 == zero) {
+        split_diagonal_update update{u00, u11, classify_phase(u00), classify_phase(u11)};
+        sweep_pairs(re, im, count, stride, run, low, high, set_bits, update);
+        return true;
+    }
+    if ((structure == gate_structure::permutation || structure == gate_structure::phase_permutation)
+        && u00 == zero && u11 == zero) {
+        split_antidiagonal_update update{u01, u10, classify_phase(u01), classify_phase(u10)};
+        sweep_pairs(re, im, count, stride, run, low, high, set_bits, update);
+        return true;
+    }
+    return false;
+}
+
+void split_statevector::apply_single(int qubit, const matrix &gate, gate_structure structure) {
+    if (qubit < 0 || qubit >= qubits) {
+        throw std::out_of_range("Qubit index out of range.");
+    }
+    double* re = real_parts.data();
+    double* im = imag_parts.data();
+    const std::size_t stride = std::size_t{1} << qubit;
+    if (apply_structured(re, im, real_parts.size() >> 1, stride, stride, qubit, -1, 0, gate, structure)) {
+        return;
+    }
+    const simd::gate2 u = simd::make_gate2(gate);
+    parallel_sweep(real_parts.size() >> 1, [&](std::size_t begin, std::size_t end) {
+        simd::apply_single(re, im, qubit, begin, end, u);
+    });
+}
+
+void split_statevector::apply_controlled(int control, int target, const matrix &gate, gate_structure structure) {
+    if (control < 0 || control >= qubits || target < 0 || target >= qubits || control == target) {
+        throw std::out_of_range("Invalid control/target qubits.");
+    }
+    double* re = real_parts.data();
+    double* im = imag_parts.data();
+    const int low = std::min(control, target);
+    const int high = std::max(control, target);
+    if (apply_structured(re, im, real_parts.size() >> 2, std::size_t{1} << target, std::size_t{1} << low,
+                         low, high, std::size_t{1} << control, gate, structure)) {
+        return;
+    }
+    const simd::gate2 u = simd::make_gate2(gate);
+    parallel_sweep(real_parts.size() >> 2, [&](std::size_t begin, std::size_t end) {
+        simd::apply_controlled(re, im, control, target, begin, end, u);
+    });
+}
+
+// Apply a batch of diagonal gates in one sweep, multiplying each amplitude by its matching phases
+void split_statevector::apply_diagonal(const std::vector<diagonal_factor> &factors) {
+    if (factors.empty()) {
+        return;
+    }
+    const diagonal_factor* factor = factors.data();
+    const std::size_t count = factors.size();
+    double* re = real_parts.data();
+    double* im = imag_parts.data();
+    if (all_sign_flips(factors)) {  // Z/CZ-only batches reduce to a parity-controlled sign
+        parallel_sweep(real_parts.size(), [=](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                std::size_t flips = 0;
+                for (std::size_t f = 0; f < count; f++) {
+                    flips ^= ((i & factor[f].mask) == factor[f].value);
+                }
+                const double sign = 1.0 - 2.0 * static_cast<double>(flips);
+                re[i] *= sign;
+                im[i] *= sign;
+            }
+        });
+        return;
+    }
+    parallel_sweep(real_parts.size(), [=](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            for (std::size_t f = 0; f < count; f++) {
+                if ((i & factor[f].mask) == factor[f].value) {
+                    apply_phase_parts(factor[f].kind, factor[f].phase, re[i], im[i]);
+                }
+            }
+        }
+    });
+}
+
+// Apply a dense block to a few qubits: gather 2^k amplitudes per base index, multiply, scatter back
+void split_statevector::apply_dense(const gate_qubits &targets, const matrix &block) {
+    const int k = static_cast<int>(targets.size());
+    const int dim = 1 << k;
+    if (k < 1 || k > max_dense_qubits || k > qubits || block.get_rows() != dim || block.get_cols() != dim) {
+        throw std::invalid_argument("Invalid dense block.");
+    }
+    // Scratch buffers are engine members so they keep their capacity across calls
+    std::vector<int>& sorted = dense_sorted;
+    sorted.assign(targets.begin(), targets.end());
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end() || sorted.front() < 0 || sorted.back() >= qubits) {
+        throw std::out_of_range("Invalid block qubits.");
+    }
+
+    std::vector<std::size_t>& offsets = dense_offsets;
+    std::vector<double>& u_re = dense_re;
+    std::vector<double>& u_im = dense_im;
+    offsets.assign(dim, 0);
+    u_re.resize(dim * dim);
+    u_im.resize(dim * dim);
+    for (int l = 0; l < dim; l++) {
+        for (int j = 0; j < k; j++) {
+            if ((l >> j) & 1) {
+                offsets[l] |= std::size_t{1} << targets[j];
+            }
+        }
+    }
+    for (int e = 0; e < dim * dim; e++) {
+        u_re[e] = block.data()[e].real();
+        u_im[e] = block.data()[e].imag();
+    }
+    const std::size_t* offset = offsets.data();
+    const double* ur = u_re.data();
+    const double* ui = u_im.data();
+    const int* positions = sorted.data();
+    double* re = real_parts.data();
+    double* im = imag_parts.data();
+    parallel_sweep(real_parts.size() >> k, [=](std::size_t begin, std::size_t end) {
+        double in_re[1 << max_dense_qubits];
+        double in_im[1 << max_dense_qubits];
+        for (std::size_t b = begin; b < end; b++) {
+            std::size_t base = b;
+            for (int j = 0; j < k; j++) {
+                base = insert_zero_bit(base, positions[j]);
+            }
+            for (int l = 0; l < dim; l++) {
+                in_re[l] = re[base + offset[l]];
+                in_im[l] = im[base + offset[l]];
+            }
+            for (int r = 0; r < dim; r++) {
+                double sum_re = 0;
+                double sum_im = 0;
+                for (int c = 0; c < dim; c++) {
+                    sum_re += ur[r * dim + c] * in_re[c] - ui[r * dim + c] * in_im[c];
+                    sum_im += ur[r * dim + c] * in_im[c] + ui[r * dim + c] * in_re[c];
+                }
+                re[base + offset[r]] = sum_re;
+                im[base + offset[r]] = sum_im;
+            }
+        }
+    });
+}
+
+// Copy amplitudes out as a (2^n x 1) column vector
+matrix split_statevector::to_matrix() const {
+    const int size = static_cast<int>(real_parts.size());
+    matrix output{size, 1};
+    for (int i = 0; i < size; i++) {
+        output.at(i, 0) = std::complex<double>{real_parts[i], imag_parts[i]};
+    }
+    return output;
+}
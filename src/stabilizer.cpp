@@ -0,0 +1,343 @@
+#include "stabilizer.h"
+#include <algorithm>
+#include <stdexcept>
+#include "profiler.h"
+
+stabilizer_tableau::stabilizer_tableau(const std::vector<char> &initial_states)
+    : qubits{static_cast<int>(initial_states.size())} {
+    if (qubits < 1) {
+        throw std::invalid_argument("Tableau needs at least one qubit.");
+    }
+    words = (static_cast<std::size_t>(qubits) + 63) / 64;
+    const std::size_t rows = 2 * static_cast<std::size_t>(qubits) + 1;
+    xs.assign(rows * words, 0);
+    zs.assign(rows * words, 0);
+    signs.assign(rows, 0);
+    // |0...0>: destabilizer q is X_q, stabilizer q is Z_q
+    for (int q = 0; q < qubits; q++) {
+        x_row(q)[q >> 6] |= std::uint64_t{1} << (q & 63);
+        z_row(qubits + q)[q >> 6] |= std::uint64_t{1} << (q & 63);
+    }
+    for (int q = 0; q < qubits; q++) {
+        if (initial_states[q] == '1') {
+            apply_x(q);
+        } else if (initial_states[q] != '0') {
+            throw std::invalid_argument("Initial states must be '0' or '1'.");
+        }
+    }
+}
+
+int stabilizer_tableau::get_qubits() const {
+    return qubits;
+}
+
+void stabilizer_tableau::check_qubit(int q) const {
+    if (q < 0 || q >= qubits) {
+        throw std::out_of_range("Qubit index out of range.");
+    }
+}
+
+// Multiplies Pauli rows word by word, tracking the power of i picked up at each bit position mod 4
+// in two bit planes (cnt1 = bit 0, cnt2 = bit 1)
+void stabilizer_tableau::rowsum(std::size_t h, std::size_t i) {
+    std::uint64_t* xh = x_row(h);
+    std::uint64_t* zh = z_row(h);
+    const std::uint64_t* xi = x_row(i);
+    const std::uint64_t* zi = z_row(i);
+    std::uint64_t cnt1 = 0;
+    std::uint64_t cnt2 = 0;
+    for (std::size_t w = 0; w < words; w++) {
+        const std::uint64_t x1 = xh[w], z1 = zh[w];
+        const std::uint64_t x2 = xi[w], z2 = zi[w];
+        const std::uint64_t x = x1 ^ x2;
+        const std::uint64_t z = z1 ^ z2;
+        const std::uint64_t x1z2 = x1 & z2;
+        const std::uint64_t anti_commutes = (x2 & z1) ^ x1z2;
+        cnt2 ^= (cnt1 ^ x ^ z ^ x1z2) & anti_commutes;
+        cnt1 ^= anti_commutes;
+        xh[w] = x;
+        zh[w] = z;
+    }
+    const int log_i = (__builtin_popcountll(cnt1) + 2 * __builtin_popcountll(cnt2)) & 3;
+    signs[h] ^= signs[i] ^ ((log_i >> 1) & 1);
+}
+
+void stabilizer_tableau::copy_row(std::size_t to, std::size_t from) {
+    std::copy(x_row(from), x_row(from) + words, x_row(to));
+    std::copy(z_row(from), z_row(from) + words, z_row(to));
+    signs[to] = signs[from];
+}
+
+void stabilizer_tableau::clear_row(std::size_t row) {
+    std::fill(x_row(row), x_row(row) + words, 0);
+    std::fill(z_row(row), z_row(row) + words, 0);
+    signs[row] = 0;
+}
+
+// Single-qubit updates touch one bit per row: w is the word holding qubit q, b its bit position
+void stabilizer_tableau::apply_h(int q) {
+    check_qubit(q);
+    const std::size_t w = q >> 6;
+    const int b = q & 63;
+    for (std::size_t row = 0; row < 2 * static_cast<std::size_t>(qubits); row++) {
+        std::uint64_t &xw = x_row(row)[w];
+        std::uint64_t &zw = z_row(row)[w];
+        const std::uint64_t x = (xw >> b) & 1;
+        const std::uint64_t z = (zw >> b) & 1;
+        signs[row] ^= x & z;
+        xw ^= (x ^ z) << b;
+        zw ^= (x ^ z) << b;
+    }
+}
+
+void stabilizer_tableau::apply_s(int q) {
+    check_qubit(q);
+    const std::size_t w = q >> 6;
+    const int b = q & 63;
+    for (std::size_t row = 0; row < 2 * static_cast<std::size_t>(qubits); row++) {
+        const std::uint64_t x = (x_row(row)[w] >> b) & 1;
+        const std::uint64_t z = (z_row(row)[w] >> b) & 1;
+        signs[row] ^= x & z;
+        z_row(row)[w] ^= x << b;
+    }
+}
+
+void stabilizer_tableau::apply_sdg(int q) {
+    apply_s(q);
+    apply_z(q);
+}
+
+// Paulis only change signs: X flips rows with a Z part on q, Z rows with an X part, Y both
+void stabilizer_tableau::apply_x(int q) {
+    check_qubit(q);
+    for (std::size_t row = 0; row < 2 * static_cast<std::size_t>(qubits); row++) {
+        signs[row] ^= z_bit(row, q);
+    }
+}
+
+void stabilizer_tableau::apply_y(int q) {
+    check_qubit(q);
+    for (std::size_t row = 0; row < 2 * static_cast<std::size_t>(qubits); row++) {
+        signs[row] ^= x_bit(row, q) ^ z_bit(row, q);
+    }
+}
+
+void stabilizer_tableau::apply_z(int q) {
+    check_qubit(q);
+    for (std::size_t row = 0; row < 2 * static_cast<std::size_t>(qubits); row++) {
+        signs[row] ^= x_bit(row, q);
+    }
+}
+
+void stabilizer_tableau::apply_cx(int control, int target) {
+    check_qubit(control);
+    check_qubit(target);
+    if (control == target) {
+        throw std::invalid_argument("Control and target must differ.");
+    }
+    const std::size_t wc = control >> 6, wt = target >> 6;
+    const int bc = control & 63, bt = target & 63;
+    for (std::size_t row = 0; row < 2 * static_cast<std::size_t>(qubits); row++) {
+        std::uint64_t* x = x_row(row);
+        std::uint64_t* z = z_row(row);
+        const std::uint64_t xc = (x[wc] >> bc) & 1, zc = (z[wc] >> bc) & 1;
+        const std::uint64_t xt = (x[wt] >> bt) & 1, zt = (z[wt] >> bt) & 1;
+        signs[row] ^= xc & zt & (xt ^ zc ^ 1);
+        x[wt] ^= xc << bt;
+        z[wc] ^= zt << bc;
+    }
+}
+
+// CY = S_t CX S_t^dagger and CZ = H_t CX H_t
+void stabilizer_tableau::apply_cy(int control, int target) {
+    apply_sdg(target);
+    apply_cx(control, target);
+    apply_s(target);
+}
+
+void stabilizer_tableau::apply_cz(int control, int target) {
+    apply_h(target);
+    apply_cx(control, target);
+    apply_h(target);
+}
+
+void stabilizer_tableau::apply(const component &comp) {
+    switch (comp.op) {
+        case gate_opcode::x: apply_x(comp.qubits[0]); break;
+        case gate_opcode::y: apply_y(comp.qubits[0]); break;
+        case gate_opcode::z: apply_z(comp.qubits[0]); break;
+        case gate_opcode::h: apply_h(comp.qubits[0]); break;
+        case gate_opcode::cx: apply_cx(comp.qubits[0], comp.qubits[1]); break;
+        case gate_opcode::cy: apply_cy(comp.qubits[0], comp.qubits[1]); break;
+        case gate_opcode::cz: apply_cz(comp.qubits[0], comp.qubits[1]); break;
+        default:
+            throw std::invalid_argument(std::string("Gate is not supported by the stabilizer backend: ") + get_gate_info(comp.op).name);
+    }
+    profile::count_work(1, 0, 0);
+}
+
+int stabilizer_tableau::measure(int q, std::mt19937_64 &rng) {
+    check_qubit(q);
+    const std::size_t n = qubits;
+    std::size_t p = n;
+    while (p < 2 * n && !x_bit(p, q)) {
+        p++;
+    }
+    if (p < 2 * n) {
+        // Random outcome: a stabilizer anticommutes with Z_q
+        for (std::size_t row = 0; row < 2 * n; row++) {
+            if (row != p && x_bit(row, q)) {
+                rowsum(row, p);
+            }
+        }
+        copy_row(p - n, p);
+        clear_row(p);
+        const int outcome = static_cast<int>(rng() & 1);
+        z_row(p)[q >> 6] |= std::uint64_t{1} << (q & 63);
+        signs[p] = static_cast<std::uint8_t>(outcome);
+        return outcome;
+    }
+    // Deterministic outcome: Z_q is a product of stabilizers, collected in the scratch row
+    clear_row(2 * n);
+    for (std::size_t row = 0; row < n; row++) {
+        if (x_bit(row, q)) {
+            rowsum(2 * n, row + n);
+        }
+    }
+    return signs[2 * n];
+}
+
+std::vector<std::string> stabilizer_tableau::get_stabilizers() const {
+    std::vector<std::string> generators;
+    for (int row = qubits; row < 2 * qubits; row++) {
+        std::string pauli(qubits + 1, 'I');
+        pauli[0] = signs[row] ? '-' : '+';
+        for (int q = 0; q < qubits; q++) {
+            const bool x = x_bit(row, q);
+            const bool z = z_bit(row, q);
+            pauli[qubits - q] = x ? (z ? 'Y' : 'X') : (z ? 'Z' : 'I');
+        }
+        generators.push_back(pauli);
+    }
+    return generators;
+}
+
+// Outcomes form offset + span(basis): the X parts of the stabilizers (after elimination) span the
+// directions, and the remaining Z-only stabilizers fix the offset
+void stabilizer_tableau::support(std::vector<std::uint64_t> &offset, std::vector<std::vector<std::uint64_t>> &basis) const {
+    stabilizer_tableau t = *this;
+    const std::size_t n = qubits;
+    const std::size_t scratch = 2 * n;
+    std::size_t rank = 0;
+    for (int q = 0; q < qubits; q++) {
+        std::size_t row = n + rank;
+        while (row < 2 * n && !t.x_bit(row, q)) {
+            row++;
+        }
+        if (row == 2 * n) {
+            continue;
+        }
+        t.copy_row(scratch, row);
+        t.copy_row(row, n + rank);
+        t.copy_row(n + rank, scratch);
+        for (std::size_t other = n; other < 2 * n; other++) {
+            if (other != n + rank && t.x_bit(other, q)) {
+                t.rowsum(other, n + rank);
+            }
+        }
+        basis.push_back(std::vector<std::uint64_t>(t.x_row(n + rank), t.x_row(n + rank) + words));
+        rank++;
+    }
+
+    // Reduce the Z-only rows; each then pins its pivot bit to its sign
+    offset.assign(words, 0);
+    std::size_t fixed = rank;
+    for (int q = 0; q < qubits; q++) {
+        std::size_t row = n + fixed;
+        while (row < 2 * n && !t.z_bit(row, q)) {
+            row++;
+        }
+        if (row == 2 * n) {
+            continue;
+        }
+        t.copy_row(scratch, row);
+        t.copy_row(row, n + fixed);
+        t.copy_row(n + fixed, scratch);
+        for (std::size_t other = n + rank; other < 2 * n; other++) {
+            if (other != n + fixed && t.z_bit(other, q)) {
+                t.rowsum(other, n + fixed);
+            }
+        }
+        fixed++;
+    }
+    for (std::size_t row = n + rank; row < 2 * n; row++) {
+        const std::uint64_t* z = t.z_row(row);
+        for (std::size_t w = 0; w < words; w++) {
+            if (z[w] != 0) {
+                offset[w] |= static_cast<std::uint64_t>(t.signs[row]) << __builtin_ctzll(z[w]);
+                break;
+            }
+        }
+    }
+}
+
+std::map<std::string, std::uint64_t> stabilizer_tableau::sample_counts(std::uint64_t shots, const std::vector<int> &measured,
+                                                                       std::mt19937_64 &rng) const {
+    std::vector<int> targets = measured;
+    if (targets.empty()) {
+        for (int q = 0; q < qubits; q++) {
+            targets.push_back(q);
+        }
+    }
+    std::sort(targets.begin(), targets.end());
+    if (std::adjacent_find(targets.begin(), targets.end()) != targets.end() || targets.front() < 0 || targets.back() >= qubits) {
+        throw std::out_of_range("Measured qubits must be distinct and within the register.");
+    }
+
+    std::vector<std::uint64_t> offset;
+    std::vector<std::vector<std::uint64_t>> basis;
+    support(offset, basis);
+
+    // Project onto the measured qubits, keeping only directions that move them
+    const int k = static_cast<int>(targets.size());
+    const std::size_t out_words = (static_cast<std::size_t>(k) + 63) / 64;
+    auto project = [&](const std::vector<std::uint64_t> &v) {
+        std::vector<std::uint64_t> bits(out_words, 0);
+        for (int j = 0; j < k; j++) {
+            const int q = targets[j];
+            bits[j >> 6] |= ((v[q >> 6] >> (q & 63)) & 1) << (j & 63);
+        }
+        return bits;
+    };
+    const std::vector<std::uint64_t> start = project(offset);
+    std::vector<std::vector<std::uint64_t>> directions;
+    for (const auto& b : basis) {
+        std::vector<std::uint64_t> d = project(b);
+        if (std::any_of(d.begin(), d.end(), [](std::uint64_t w) { return w != 0; })) {
+            directions.push_back(d);
+        }
+    }
+
+    std::map<std::string, std::uint64_t> counts;
+    std::vector<std::uint64_t> outcome(out_words);
+    std::string bits(k, '0');
+    for (std::uint64_t s = 0; s < shots; s++) {
+        outcome = start;
+        std::uint64_t random = 0;
+        for (std::size_t d = 0; d < directions.size(); d++) {
+            if ((d & 63) == 0) {
+                random = rng();
+            }
+            if ((random >> (d & 63)) & 1) {
+                for (std::size_t w = 0; w < out_words; w++) {
+                    outcome[w] ^= directions[d][w];
+                }
+            }
+        }
+        for (int j = 0; j < k; j++) {
+            bits[k - 1 - j] = ((outcome[j >> 6] >> (j & 63)) & 1) ? '1' : '0';
+        }
+        counts[bits]++;
+    }
+    return counts;
+}
@@ -0,0 +1,533 @@
+#include "statevector.h"
+#include <stdexcept>
+#include <algorithm>
+#include "thread_pool.h"
+#include "gate_op.h"
+
+// Returns k with a zero bit inserted at position bit (higher bits shifted up)
+static inline std::size_t insert_zero_bit(std::size_t k, int bit) {
+    std::size_t low_mask = (std::size_t{1} << bit) - 1;
+    return ((k & ~low_mask) << 1) | (k & low_mask);
+}
+
+// Constructor (register initialised to |0...0>)
+template <typename T>
+basic_statevector<T>::basic_statevector(int qubits) : amplitudes(std::size_t{1} << qubits), qubits{qubits} {
+    amplitudes[0] = std::complex<T>{1, 0};
+}
+
+// Constructor from column vector
+template <typename T>
+basic_statevector<T>::basic_statevector(const matrix &input) : qubits{0} {
+    if (input.get_cols() != 1 || input.get_rows() < 1) {
+        throw std::invalid_argument("Input must be a column vector.");
+    }
+    while ((1 << qubits) < input.get_rows()) {
+        qubits++;
+    }
+    if ((1 << qubits) != input.get_rows()) {
+        throw std::invalid_argument("Input vector size must be a power of 2.");
+    }
+    amplitudes.resize(input.get_rows());
+    for (int i = 0; i < input.get_rows(); i++) {
+        amplitudes[i] = std::complex<T>(input.get_value(i + 1, 1));
+    }
+}
+
+// Accessors
+template <typename T>
+int basic_statevector<T>::get_qubits() const {
+    return qubits;
+}
+
+template <typename T>
+std::size_t basic_statevector<T>::get_size() const {
+    return amplitudes.size();
+}
+
+template <typename T>
+std::complex<T>* basic_statevector<T>::data() {
+    return amplitudes.data();
+}
+
+template <typename T>
+const std::complex<T>* basic_statevector<T>::data() const {
+    return amplitudes.data();
+}
+
+// Calls update(a0, a1) on each amplitude pair (i, i + 2^qubit)
+template <typename T, typename Update>
+static void sweep_single(std::complex<T>* amp, std::size_t size, int qubit, Update update) {
+    const std::size_t stride = std::size_t{1} << qubit;
+    parallel_sweep(size >> 1, [=](std::size_t begin, std::size_t end) {
+        std::size_t k = begin;
+        while (k < end) {  // Walk the pair range in runs of contiguous amplitudes
+            const std::size_t len = std::min(end - k, stride - (k & (stride - 1)));
+            const std::size_t first = insert_zero_bit(k, qubit);
+            for (std::size_t i = first; i < first + len; i++) {
+                update(amp[i], amp[i + stride]);
+            }
+            k += len;
+        }
+    });
+}
+
+// Calls update(a0, a1) on each pair with the control bit set, a0 having the target bit clear
+template <typename T, typename Update>
+static void sweep_controlled(std::complex<T>* amp, std::size_t size, int control, int target, Update update) {
+    const std::size_t control_bit = std::size_t{1} << control;
+    const std::size_t stride = std::size_t{1} << target;
+    const int low = std::min(control, target);
+    const int high = std::max(control, target);
+    const std::size_t run = std::size_t{1} << low;
+    parallel_sweep(size >> 2, [=](std::size_t begin, std::size_t end) {
+        std::size_t k = begin;
+        while (k < end) {
+            // Insert a zero bit at the low and high qubit positions, then set the control bit
+            const std::size_t len = std::min(end - k, run - (k & (run - 1)));
+            const std::size_t first = insert_zero_bit(insert_zero_bit(k, low), high) | control_bit;
+            for (std::size_t i = first; i < first + len; i++) {
+                update(amp[i], amp[i + stride]);
+            }
+            k += len;
+        }
+    });
+}
+
+// Pair updates for each gate structure
+template <typename T>
+struct dense_update
+{
+    std::complex<T> u00, u01, u10, u11;
+    void operator()(std::complex<T> &a0, std::complex<T> &a1) const {
+        const std::complex<T> b0 = a0;
+        a0 = u00 * b0 + u01 * a1;
+        a1 = u10 * b0 + u11 * a1;
+    }
+};
+
+template <typename T>
+struct diagonal_update
+{
+    std::complex<T> d0, d1;
+    phase_kind k0, k1;
+    void operator()(std::complex<T> &a0, std::complex<T> &a1) const {
+        a0 = apply_phase(k0, d0, a0);
+        a1 = apply_phase(k1, d1, a1);
+    }
+};
+
+template <typename T>
+struct antidiagonal_update
+{
+    std::complex<T> f01, f10;
+    phase_kind k01, k10;
+    void operator()(std::complex<T> &a0, std::complex<T> &a1) const {
+        const std::complex<T> b0 = a0;
+        a0 = apply_phase(k01, f01, a1);
+        a1 = apply_phase(k10, f10, b0);
+    }
+};
+
+// Picks the cheapest pair update for a 2x2 gate and hands it to sweep; the structure is decided on the
+// double entries, which are then rounded to the amplitude type
+template <typename T, typename Sweep>
+static void dispatch_2x2(const matrix &gate, gate_structure structure, const Sweep &sweep) {
+    typedef std::complex<T> amplitude;
+    const std::complex<double> zero{0, 0};
+    const std::complex<double> u00 = gate.get_value(1, 1);
+    const std::complex<double> u01 = gate.get_value(1, 2);
+    const std::complex<double> u10 = gate.get_value(2, 1);
+    const std::complex<double> u11 = gate.get_value(2, 2);
+
+    if (structure == gate_structure::diagonal && u01 == zero && u10 == zero) {
+        if (u00 == std::complex<double>{1, 0} && u11 == std::complex<double>{1, 0}) {
+            return;  // Identity
+        }
+        sweep(diagonal_update<T>{amplitude(u00), amplitude(u11), classify_phase(u00), classify_phase(u11)});
+    } else if ((structure == gate_structure::permutation || structure == gate_structure::phase_permutation)
+               && u00 == zero && u11 == zero) {
+        sweep(antidiagonal_update<T>{amplitude(u01), amplitude(u10), classify_phase(u01), classify_phase(u10)});
+    } else {
+        sweep(dense_update<T>{amplitude(u00), amplitude(u01), amplitude(u10), amplitude(u11)});
+    }
+}
+
+template <typename T>
+struct single_sweep
+{
+    std::complex<T>* amp;
+    std::size_t size;
+    int qubit;
+    template <typename Update> void operator()(Update update) const { sweep_single(amp, size, qubit, update); }
+};
+
+template <typename T>
+struct controlled_sweep
+{
+    std::complex<T>* amp;
+    std::size_t size;
+    int control, target;
+    template <typename Update> void operator()(Update update) const { sweep_controlled(amp, size, control, target, update); }
+};
+
+// Apply a 2x2 gate to one qubit by updating each amplitude pair (i, i + 2^qubit) in place
+template <typename T>
+void basic_statevector<T>::apply_single(int qubit, const matrix &gate, gate_structure structure) {
+    if (qubit < 0 || qubit >= qubits) {
+        throw std::out_of_range("Qubit index out of range.");
+    }
+    dispatch_2x2<T>(gate, structure, single_sweep<T>{amplitudes.data(), amplitudes.size(), qubit});
+}
+
+// Apply a 2x2 gate to the target qubit, only on amplitudes whose control bit is set
+template <typename T>
+void basic_statevector<T>::apply_controlled(int control, int target, const matrix &gate, gate_structure structure) {
+    if (control < 0 || control >= qubits || target < 0 || target >= qubits || control == target) {
+        throw std::out_of_range("Invalid control/target qubits.");
+    }
+    dispatch_2x2<T>(gate, structure, controlled_sweep<T>{amplitudes.data(), amplitudes.size(), control, target});
+}
+
+// Apply a batch of diagonal gates in one sweep, multiplying each amplitude by its matching phases
+template <typename T>
+void basic_statevector<T>::apply_diagonal(const std::vector<diagonal_factor> &factors) {
+    if (factors.empty()) {
+        return;
+    }
+    const diagonal_factor* factor = factors.data();
+    const std::size_t count = factors.size();
+    if (all_sign_flips(factors)) {  // Z/CZ-only batches reduce to a parity-controlled sign
+        T* parts = reinterpret_cast<T*>(amplitudes.data());
+        parallel_sweep(amplitudes.size(), [=](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                std::size_t flips = 0;
+                for (std::size_t f = 0; f < count; f++) {
+                    flips ^= ((i & factor[f].mask) == factor[f].value);
+                }
+                const T sign = T(1) - T(2) * static_cast<T>(flips);
+                parts[2 * i] *= sign;
+                parts[2 * i + 1] *= sign;
+            }
+        });
+        return;
+    }
+    std::complex<T>* amp = amplitudes.data();
+    parallel_sweep(amplitudes.size(), [=](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            std::complex<T> a = amp[i];
+            for (std::size_t f = 0; f < count; f++) {
+                if ((i & factor[f].mask) == factor[f].value) {
+                    a = apply_phase(factor[f].kind, std::complex<T>(factor[f].phase), a);
+                }
+            }
+            amp[i] = a;
+        }
+    });
+}
+
+// Apply a dense block to a few qubits: gather 2^k amplitudes per base index, multiply, scatter back
+template <typename T>
+void basic_statevector<T>::apply_dense(const gate_qubits &targets, const matrix &block) {
+    const int k = static_cast<int>(targets.size());
+    const int dim = 1 << k;
+    if (k < 1 || k > max_dense_qubits || k > qubits || block.get_rows() != dim || block.get_cols() != dim) {
+        throw std::invalid_argument("Invalid dense block.");
+    }
+    // Scratch buffers are engine members so they keep their capacity across calls
+    std::vector<int>& sorted = dense_sorted;
+    sorted.assign(targets.begin(), targets.end());
+    std::sort(sorted.begin(), sorted.end());
+    if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end() || sorted.front() < 0 || sorted.back() >= qubits) {
+        throw std::out_of_range("Invalid block qubits.");
+    }
+
+    std::vector<std::size_t>& offsets = dense_offsets;  // Amplitude offset of each local index
+    offsets.assign(dim, 0);
+    for (int l = 0; l < dim; l++) {
+        for (int j = 0; j < k; j++) {
+            if ((l >> j) & 1) {
+                offsets[l] |= std::size_t{1} << targets[j];
+            }
+        }
+    }
+    // Block split into real and imaginary parts so the inner product avoids std::complex multiply
+    std::vector<T>& u_re = dense_re;
+    std::vector<T>& u_im = dense_im;
+    u_re.resize(dim * dim);
+    u_im.resize(dim * dim);
+    for (int e = 0; e < dim * dim; e++) {
+        u_re[e] = static_cast<T>(block.data()[e].real());
+        u_im[e] = static_cast<T>(block.data()[e].imag());
+    }
+    const T* ur = u_re.data();
+    const T* ui = u_im.data();
+    const std::size_t* offset = offsets.data();
+    const int* positions = sorted.data();
+    T* amp = reinterpret_cast<T*>(amplitudes.data());
+    parallel_sweep(amplitudes.size() >> k, [=](std::size_t begin, std::size_t end) {
+        T in_re[1 << max_dense_qubits];
+        T in_im[1 << max_dense_qubits];
+        for (std::size_t b = begin; b < end; b++) {
+            std::size_t base = b;
+            for (int j = 0; j < k; j++) {
+                base = insert_zero_bit(base, positions[j]);
+            }
+            for (int l = 0; l < dim; l++) {
+                in_re[l] = amp[2 * (base + offset[l])];
+                in_im[l] = amp[2 * (base + offset[l]) + 1];
+            }
+            for (int r = 0; r < dim; r++) {
+                T sum_re = 0;
+                T sum_im = 0;
+                for (int c = 0; c < dim; c++) {
+                    sum_re += ur[r * dim + c] * in_re[c] - ui[r * dim + c] * in_im[c];
+                    sum_im += ur[r * dim + c] * in_im[c] + ui[r * dim + c] * in_re[c];
+                }
+                amp[2 * (base + offset[r])] = sum_re;
+                amp[2 * (base + offset[r]) + 1] = sum_im;
+            }
+        }
+    });
+}
+
+// Qubits spanned by one tile of a layer pass; 2^12 amplitudes stay in the L2 cache
+static const int layer_tile_qubits = 12;
+
+// Calls update(a0, a1) on each pair (i, i + 2^target) of a tile buffer whose local control bits are all set
+template <typename T>
+struct tile_sweep
+{
+    std::complex<T>* buffer;
+    std::size_t len;
+    int target;
+    std::size_t control_mask;
+    template <typename Update> void operator()(Update update) const {
+        const std::size_t stride = std::size_t{1} << target;
+        for (std::size_t first = 0; first < len; first += 2 * stride) {  // Runs of contiguous pairs
+            for (std::size_t i = first; i < first + stride; i++) {
+                if ((i & control_mask) == control_mask) {
+                    update(buffer[i], buffer[i + stride]);
+                }
+            }
+        }
+    }
+};
+
+// Gate of a layer pass in tile coordinates
+template <typename T>
+struct tile_gate
+{
+    const gate_op* op;
+    std::vector<int> targets;            // Tile bits the gate mixes
+    std::size_t local_control;           // Controlled gates: control bit within the tile (0 if outside)
+    std::size_t global_control;          // Controlled gates: control bit of the register when outside the tile
+    std::vector<std::complex<T>> block;  // Dense gates: the block rounded to the amplitude type
+    std::vector<std::size_t> offsets;    // Dense gates: tile offset of each block index
+};
+
+// Multiplies every 2^k group of a tile buffer by a dense block on the given tile bits
+template <typename T>
+static void tile_dense(std::complex<T>* buffer, std::size_t len, const tile_gate<T> &gate) {
+    const int k = static_cast<int>(gate.targets.size());
+    const int dim = 1 << k;
+    std::vector<int> sorted = gate.targets;
+    std::sort(sorted.begin(), sorted.end());
+    std::complex<T> in[1 << max_dense_qubits];
+    for (std::size_t b = 0; b < len >> k; b++) {
+        std::size_t base = b;
+        for (int position : sorted) {
+            base = insert_zero_bit(base, position);
+        }
+        for (int l = 0; l < dim; l++) {
+            in[l] = buffer[base + gate.offsets[l]];
+        }
+        for (int r = 0; r < dim; r++) {
+            std::complex<T> sum{0, 0};
+            for (int c = 0; c < dim; c++) {
+                sum += gate.block[r * dim + c] * in[c];
+            }
+            buffer[base + gate.offsets[r]] = sum;
+        }
+    }
+}
+
+// One pass of a layer: the register is split into tiles over the given bits (topped up with the lowest
+// other bits); each tile is gathered into a buffer, run through every gate and phase, and written back
+template <typename T>
+static void layer_pass(std::complex<T>* amp, int qubits, std::vector<int> bits, const std::vector<const gate_op*> &gates,
+                       const std::vector<diagonal_factor> &factors) {
+    const int tile = std::min(qubits, layer_tile_qubits);
+    for (int q = 0; static_cast<int>(bits.size()) < tile; q++) {
+        if (std::find(bits.begin(), bits.end(), q) == bits.end()) {
+            bits.push_back(q);
+        }
+    }
+    std::sort(bits.begin(), bits.end());
+    std::vector<int> local(qubits, -1);
+    for (int j = 0; j < tile; j++) {
+        local[bits[j]] = j;
+    }
+    const std::size_t len = std::size_t{1} << tile;
+    std::vector<std::size_t> offsets(len, 0);  // Register offset of each tile index
+    for (std::size_t l = 0; l < len; l++) {
+        for (int j = 0; j < tile; j++) {
+            if ((l >> j) & 1) {
+                offsets[l] |= std::size_t{1} << bits[j];
+            }
+        }
+    }
+
+    std::vector<tile_gate<T>> tile_gates;
+    for (const gate_op* op : gates) {
+        tile_gate<T> g{op, {}, 0, 0, {}, {}};
+        if (op->kind == gate_op::controlled) {
+            g.targets.push_back(local[op->qubits[1]]);
+            const int control = op->qubits[0];
+            if (local[control] >= 0) {
+                g.local_control = std::size_t{1} << local[control];
+            } else {
+                g.global_control = std::size_t{1} << control;
+            }
+        } else {
+            for (int q : op->qubits) {
+                g.targets.push_back(local[q]);
+            }
+        }
+        if (op->kind == gate_op::dense) {
+            const int dim = op->m->get_rows();
+            for (int e = 0; e < dim * dim; e++) {
+                g.block.push_back(std::complex<T>(op->m->data()[e]));
+            }
+            g.offsets.assign(dim, 0);
+            for (int l = 0; l < dim; l++) {
+                for (std::size_t j = 0; j < g.targets.size(); j++) {
+                    if ((l >> j) & 1) {
+                        g.offsets[l] |= std::size_t{1} << g.targets[j];
+                    }
+                }
+            }
+        }
+        tile_gates.push_back(g);
+    }
+
+    const std::size_t* offset = offsets.data();
+    auto body = [&](std::size_t begin, std::size_t end) {
+        std::vector<std::complex<T>> tile_buffer(len);
+        std::complex<T>* buffer = tile_buffer.data();
+        for (std::size_t t = begin; t < end; t++) {
+            std::size_t base = t;
+            for (int b : bits) {
+                base = insert_zero_bit(base, b);
+            }
+            for (std::size_t l = 0; l < len; l++) {
+                buffer[l] = amp[base + offset[l]];
+            }
+            for (const tile_gate<T>& g : tile_gates) {
+                if (g.global_control != 0 && (base & g.global_control) == 0) {
+                    continue;  // Control outside the tile is clear for the whole tile
+                }
+                if (g.op->kind == gate_op::dense) {
+                    tile_dense(buffer, len, g);
+                } else {
+                    dispatch_2x2<T>(*g.op->m, g.op->structure, tile_sweep<T>{buffer, len, g.targets[0], g.local_control});
+                }
+            }
+            for (const diagonal_factor& factor : factors) {
+                for (std::size_t l = 0; l < len; l++) {
+                    if (((base + offset[l]) & factor.mask) == factor.value) {
+                        buffer[l] = apply_phase(factor.kind, std::complex<T>(factor.phase), buffer[l]);
+                    }
+                }
+            }
+            for (std::size_t l = 0; l < len; l++) {
+                amp[base + offset[l]] = buffer[l];
+            }
+        }
+    };
+    // Tiles are large work items, so they are shared out even when there are few of them
+    const std::size_t tiles = std::size_t{1} << (qubits - tile);
+    thread_pool* pool = thread_pool::shared();
+    if (pool != nullptr && tiles > 1) {
+        pool->parallel_for(tiles, 1, body);
+    } else {
+        body(0, tiles);
+    }
+}
+
+// Apply a layer of gates on distinct qubits, each pass covering as many gates as fit their mixed qubits in a tile
+template <typename T>
+void basic_statevector<T>::apply_layer(const std::vector<gate_op> &gates) {
+    std::vector<bool> used(qubits, false);
+    std::vector<diagonal_factor> factors;
+    std::vector<const gate_op*> mixing;
+    for (const gate_op& op : gates) {
+        for (int q : op.qubits) {
+            if (q < 0 || q >= qubits || used[q]) {
+                throw std::invalid_argument("Layer gates must act on distinct qubits of the register.");
+            }
+            used[q] = true;
+        }
+        if (op.structure == gate_structure::diagonal) {
+            append_diagonal_factors(op, factors);
+        } else {
+            mixing.push_back(&op);
+        }
+    }
+    if (mixing.empty()) {
+        apply_diagonal(factors);
+        return;
+    }
+    const int tile = std::min(qubits, layer_tile_qubits);
+    std::size_t next = 0;
+    while (next < mixing.size()) {
+        std::vector<const gate_op*> pass;
+        std::vector<int> mixed;
+        while (next < mixing.size()) {
+            const gate_op& op = *mixing[next];
+            // A controlled gate only mixes its target
+            const std::int32_t* first = op.qubits.begin() + (op.kind == gate_op::controlled ? 1 : 0);
+            const std::size_t count = op.qubits.end() - first;
+            if (!pass.empty() && static_cast<int>(mixed.size() + count) > tile) {
+                break;
+            }
+            mixed.insert(mixed.end(), first, op.qubits.end());
+            pass.push_back(&op);
+            next++;
+        }
+        layer_pass(amplitudes.data(), qubits, mixed, pass, factors);
+        factors.clear();  // Phases go with the first pass
+    }
+}
+
+// Apply a dense operator acting on the full register
+template <typename T>
+void basic_statevector<T>::apply_matrix(const matrix &op) {
+    const int size = static_cast<int>(amplitudes.size());
+    if (op.get_rows() != size || op.get_cols() != size) {
+        throw std::invalid_argument("Operator size does not match statevector.");
+    }
+    std::vector<std::complex<T>> result(size);
+    for (int i = 0; i < size; i++) {
+        std::complex<double> sum{0, 0};
+        for (int k = 0; k < size; k++) {
+            sum += op.get_value(i + 1, k + 1) * std::complex<double>(amplitudes[k]);
+        }
+        result[i] = std::complex<T>(sum);
+    }
+    amplitudes.swap(result);
+}
+
+// Copy amplitudes out as a (2^n x 1) column vector
+template <typename T>
+matrix basic_statevector<T>::to_matrix() const {
+    const int size = static_cast<int>(amplitudes.size());
+    matrix output{size, 1};
+    for (int i = 0; i < size; i++) {
+        output.set_value(i + 1, 1, std::complex<double>(amplitudes[i]));
+    }
+    return output;
+}
+
+template class basic_statevector<double>;
+template class basic_statevector<float>;
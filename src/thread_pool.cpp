@@ -0,0 +1,110 @@
+#include "thread_pool.h"
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+// Constructor (the calling thread acts as worker 0, so threads - 1 workers are started)
+thread_pool::thread_pool(int threads) {
+    if (threads < 1) {
+        throw std::invalid_argument("Thread count must be positive.");
+    }
+    for (int id = 1; id < threads; id++) {
+        workers.emplace_back(&thread_pool::worker_loop, this, id);
+    }
+}
+
+// Destructor
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    start_signal.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int thread_pool::get_threads() const {
+    return static_cast<int>(workers.size()) + 1;
+}
+
+// Set while a thread runs a chunk, so parallel_for calls from inside a task run inline
+static thread_local bool in_task = false;
+
+void thread_pool::run_chunk(int id) {
+    std::size_t begin = id * chunk_size;
+    std::size_t end = std::min(begin + chunk_size, task_count);
+    if (begin < end) {
+        in_task = true;
+        (*task)(begin, end);
+        in_task = false;
+    }
+}
+
+void thread_pool::worker_loop(int id) {
+    unsigned long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            start_signal.wait(guard, [&]() { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        run_chunk(id);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (--pending == 0) {
+                done_signal.notify_one();
+            }
+        }
+    }
+}
+
+void thread_pool::parallel_for(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)> &body) {
+    const std::size_t threads = get_threads();
+    if (threads == 1 || count <= grain || in_task) {
+        body(0, count);
+        return;
+    }
+    // Round chunks up to whole grains so no two threads write into the same cache line
+    std::size_t chunk = (count + threads - 1) / threads;
+    chunk = (chunk + grain - 1) / grain * grain;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        task = &body;
+        task_count = count;
+        chunk_size = chunk;
+        pending = static_cast<int>(workers.size());
+        generation++;
+    }
+    start_signal.notify_all();
+    run_chunk(0);
+
+    std::unique_lock<std::mutex> guard(lock);
+    done_signal.wait(guard, [&]() { return pending == 0; });
+    task = nullptr;
+}
+
+static std::unique_ptr<thread_pool> shared_pool;
+
+thread_pool* thread_pool::shared() {
+    return shared_pool.get();
+}
+
+void thread_pool::configure_shared(int threads) {
+    if (threads < 1) {
+        throw std::invalid_argument("Thread count must be positive.");
+    }
+    if (threads == 1) {
+        shared_pool.reset();
+    } else if (!shared_pool || shared_pool->get_threads() != threads) {
+        shared_pool.reset(new thread_pool(threads));
+    }
+}
+
+void thread_pool::forget_shared() {
+    shared_pool.release();  // Deliberately leaked: destroying it would wait for the parent's workers
+}